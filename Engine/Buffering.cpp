@@ -1,87 +1,582 @@
 /*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
  *  File Name: Buffering.cpp
- *  Lib: Beeplayer Core engine Audio Buffer -> Double buffering lib
+ *  Lib: Beeplayer Core engine Audio Buffer -> Ring buffering lib
  *  Author: Romi Brooks
  *  Date: 2025-04-24
  *  Type: Buffers, Core Engine
  */
 
 #include "Buffering.hpp"
+#include "GainStage.hpp"
 
 // Standard Lib
-#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <vector>
 
-AudioBuffering::AudioBuffering(ma_decoder *decoder) {
-	p_outputSampleRate = decoder->outputSampleRate;
-	p_keepFilling = true;
-	p_bufferFillerThread = std::thread(&AudioBuffering::BufferFiller, this, decoder);
+namespace {
+	constexpr float HalfPi = 1.57079632679489661923f;
+	constexpr ma_uint64 FadeSegmentFrames = 64; // The equal-power curve is exact every this many frames, linear between
+
+	// Gains of the outgoing / incoming track at T (0..1) through the overlap
+	float FadeOutGain(CrossfadeCurve Curve, float T) { return Curve == CrossfadeCurve::Linear ? 1.0f - T : std::cos(T * HalfPi); }
+	float FadeInGain(CrossfadeCurve Curve, float T) { return Curve == CrossfadeCurve::Linear ? T : std::sin(T * HalfPi); }
+}
+
+AudioBuffering::AudioBuffering(ma_decoder *decoder, SeekIndex* index, ma_uint64 lengthFrames) {
+	StartFiller(decoder, index, lengthFrames);
 }
 
 AudioBuffering::~AudioBuffering() {
+	StopFiller();
+}
+
+void AudioBuffering::StopFiller() {
 	p_keepFilling.store(false);
-	if (p_bufferFillerThread.joinable()) {
-		p_bufferFillerThread.join();
+
+	// Kick the filler out of its wait so it can see the flag, a job that never started is dropped
+	WakeFiller();
+	p_fillerJob.CancelAndWait();
+}
+
+void AudioBuffering::StartFiller(ma_decoder *pDecoder, SeekIndex* pIndex, ma_uint64 LengthFrames, TrackId Track) {
+	StopFiller();
+
+	// The callback is not running here (device stopped or not yet initialized),
+	// so it is safe to resize the ring for the new decoder's format.
+	p_outputSampleRate = pDecoder->outputSampleRate;
+	const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(pDecoder->outputFormat, pDecoder->outputChannels);
+	// Reallocate when the frame size or the (power of two) capacity changes, a profile may shrink it too
+	const auto capacityFrames = static_cast<ma_uint64>(p_outputSampleRate * p_ringSeconds);
+	if (bytesPerFrame != p_ring.GetBytesPerFrame() || capacityFrames > p_ring.GetCapacity() || capacityFrames <= p_ring.GetCapacity() / 2) {
+		p_ring.Allocate(capacityFrames, bytesPerFrame);
+	} else {
+		p_ring.Reset();
 	}
+	UpdateWatermarks();
+
+	p_context.s_ring = &p_ring;
+	p_context.s_owner = this;
+	p_context.s_bytesPerFrame = bytesPerFrame;
+	p_context.s_channels = pDecoder->outputChannels;
+	p_context.s_floatSamples = pDecoder->outputFormat == ma_format_f32;
+
+	// Nobody publishes while the callback is stopped, so show the new stream from here
+	p_playingLength = LengthFrames;
+	p_playingTrackId = Track;
+	++p_clockEpoch;
+	PublishSnapshot();
+
+	p_keepFilling = true;
+	// The filler blocks on p_refillSignal between chunks, the callback can't take a lock to resubmit it,
+	// so the job keeps its worker for the whole stream. The service reserves a worker for exactly this.
+	p_fillerJob = DecodeService::GetInstance().Submit(DecodePriority::Stream, [this, pDecoder, pIndex, LengthFrames, Track](const std::atomic<bool>&) {
+		BufferFiller(pDecoder, pIndex, LengthFrames, Track);
+	});
 }
 
-void AudioBuffering::SwitchBuffer() { p_activeBuffer.store((p_activeBuffer.load() + 1) % 2); } // 切换缓冲区
+void AudioBuffering::SetWatermarks(float LowSeconds, float HighSeconds) {
+	p_lowWatermarkSeconds = LowSeconds;
+	p_highWatermarkSeconds = HighSeconds;
+	UpdateWatermarks();
+
+	// Let a sleeping filler re-evaluate against the new marks
+	WakeFiller();
+}
+
+void AudioBuffering::ApplyLatencyProfile(const LatencyProfile &Profile) {
+	p_ringSeconds = Profile.s_ringSeconds;
+	SetWatermarks(Profile.s_lowWatermarkSeconds, Profile.s_highWatermarkSeconds);
+}
+
+void AudioBuffering::WakeFiller() {
+	p_refillSignal.fetch_add(1, std::memory_order_release);
+	p_refillSignal.notify_one();
+}
+
+void AudioBuffering::UpdateWatermarks() {
+	const ma_uint64 capacity = p_ring.GetCapacity();
+	const auto high = std::min(static_cast<ma_uint64>(p_outputSampleRate * p_highWatermarkSeconds), capacity);
+	const auto low = std::min(static_cast<ma_uint64>(p_outputSampleRate * p_lowWatermarkSeconds), high > 0 ? high - 1 : 0);
+
+	p_highWatermark.store(high, std::memory_order_relaxed);
+	p_lowWatermark.store(low, std::memory_order_relaxed);
+}
+
+void AudioBuffering::RequestRefill() {
+	// Pairs with the fence in WaitForRefill(): either we see the filler waiting,
+	// or the filler sees the frames we just consumed.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (p_fillerWaiting.exchange(false)) {
+		WakeFiller();
+	}
+}
+
+void AudioBuffering::WaitForRefill() {
+	const ma_uint32 seen = p_refillSignal.load(std::memory_order_acquire);
+	p_fillerWaiting.store(true);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	// Re-check after announcing ourselves, the callback may have drained it meanwhile
+	if (p_keepFilling && p_ring.AvailableRead() > GetLowWatermark()) {
+		p_refillSignal.wait(seen, std::memory_order_acquire);
+	}
+	p_fillerWaiting.store(false);
+}
+
+void AudioBuffering::WaitForWork(bool TakesNext) {
+	// At the end of the track: sleep until a seek, a queued next track (gapless, unless the end was already heard) or a stop
+	const ma_uint32 seen = p_refillSignal.load(std::memory_order_acquire);
+	if (p_keepFilling && !p_seekPending && !(TakesNext && p_gapless && HasNext())) {
+		p_refillSignal.wait(seen, std::memory_order_acquire);
+	}
+}
+
+bool AudioBuffering::HoldOutput() const {
+	if (!p_paused.load(std::memory_order_relaxed)) {
+		return false;
+	}
+	// Only f32 streams go through the gain stage and get a fade, anything else is held at once
+	return !p_context.s_floatSamples || (p_rampPaused && p_rampRemaining == 0);
+}
+
+void AudioBuffering::ApplyGain(float *Samples, ma_uint64 Frames) {
+	// A new target (re)starts a ramp from wherever the gain is now, the pause fade is a bit longer
+	const bool paused = p_paused.load(std::memory_order_relaxed);
+	const float target = paused ? 0.0f : p_targetGain.load(std::memory_order_relaxed);
+	if (target != p_rampTarget || paused != p_rampPaused) {
+		const float seconds = paused != p_rampPaused ? PauseFadeSeconds : VolumeRampSeconds;
+		p_rampTarget = target;
+		p_rampPaused = paused;
+		p_rampRemaining = static_cast<ma_uint64>(p_outputSampleRate * seconds);
+	}
+
+	// The ramping part of this period, interpolated up to the frame it ends on
+	ma_uint64 done = 0;
+	if (p_rampRemaining > 0 && Frames > 0) {
+		done = std::min(Frames, p_rampRemaining);
+		const float end = done == p_rampRemaining
+							  ? p_rampTarget
+							  : p_currentGain + (p_rampTarget - p_currentGain) * static_cast<float>(done) / static_cast<float>(p_rampRemaining);
+		GainStage::Apply(Samples, done, p_context.s_channels, p_currentGain, end);
+		p_currentGain = end;
+		p_rampRemaining -= done;
+	}
+
+	// The settled rest, untouched at unity (bit-exact passthrough) unless it holds crossfaded frames: an
+	// equal-power mix peaks near 1.41 and is only clamped here. The clamp leaves in-range samples alone.
+	const bool mixed = p_ring.GetReadIndex() - Frames < p_mixedEnd.load(std::memory_order_acquire);
+	if (done < Frames && (p_currentGain != 1.0f || mixed)) {
+		GainStage::Apply(Samples + done * p_context.s_channels, Frames - done, p_context.s_channels, p_currentGain, p_currentGain);
+	}
+}
+
+void AudioBuffering::ConsumeFrames(ma_uint64 frames) {
+	// Once the read cursor passes a splice point the position restarts inside the new track.
+	// The CAS loses only if the filler cancelled the splice for a seek at the same moment.
+	const ma_uint64 played = p_ring.GetReadIndex();
+	ma_uint64 boundary = p_boundaryFrame.load(std::memory_order_acquire);
+	if (played >= boundary && p_boundaryFrame.compare_exchange_strong(boundary, NoBoundary, std::memory_order_acq_rel)) {
+		p_globalFrameCount.store(played - boundary);
+		p_playingLength = p_boundaryLength.load(std::memory_order_relaxed);
+		p_playingTrackId = p_boundaryTrackId.load(std::memory_order_relaxed);
+		++p_clockEpoch;
+		PostEvent(EngineEventType::TrackAdvanced, boundary);
+		return;
+	}
+	p_globalFrameCount += frames;
+
+	// The last frame of a track with nothing spliced behind it went out in this period.
+	// Same CAS race as above, the filler either splices in time or leaves the switch to the controller.
+	ma_uint64 end = p_endFrame.load(std::memory_order_acquire);
+	if (played >= end && p_endFrame.compare_exchange_strong(end, NoBoundary, std::memory_order_acq_rel)) {
+		PostEvent(EngineEventType::TrackEnded, end);
+	}
+
+	if (p_awaitFirstSample && frames > 0) {
+		p_awaitFirstSample = false;
+		p_lastSeekLatencyNs.store(NowNs() - p_seekRequestTimeNs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		p_seeksCompleted.fetch_add(1, std::memory_order_release);
+		PostEvent(EngineEventType::SeekCompleted, played - frames);
+	}
+}
+
+void AudioBuffering::PublishSnapshot() {
+	PlaybackSnapshot snapshot;
+	snapshot.s_frame = p_globalFrameCount.load(std::memory_order_relaxed);
+	snapshot.s_totalFrames = p_playingLength;
+	snapshot.s_timeNs = NowNs();
+	snapshot.s_sampleRate = p_outputSampleRate;
+	snapshot.s_latencyFrames = p_deviceLatencyFrames.load(std::memory_order_relaxed);
+	snapshot.s_bufferedFrames = static_cast<ma_uint32>(std::min<ma_uint64>(p_ring.AvailableRead(), std::numeric_limits<ma_uint32>::max()));
+	snapshot.s_trackId = p_playingTrackId;
+	snapshot.s_epoch = p_clockEpoch;
+	snapshot.s_state = p_playbackState.load(std::memory_order_relaxed);
+	p_snapshot.Store(snapshot);
+}
+
+double AudioBuffering::HeardFrame(const PlaybackSnapshot &Snapshot, ma_int64 AtNs) {
+	const auto handed = static_cast<double>(Snapshot.s_frame);
+	// Paused or stopped: the clock stands where playback resumes
+	if (Snapshot.s_state != PlaybackState::Playing || Snapshot.s_sampleRate == 0) {
+		return handed;
+	}
+
+	// At s_timeNs the speaker was a device buffer behind, it has moved on at the sample rate since
+	const double elapsed = static_cast<double>(std::max<ma_int64>(AtNs - Snapshot.s_timeNs, 0)) / 1e9;
+	const double heard = handed - Snapshot.s_latencyFrames + elapsed * Snapshot.s_sampleRate;
+	return std::clamp(heard, 0.0, handed);
+}
+
+double PlayheadClock::HeardFrame(const PlaybackSnapshot &Snapshot, ma_int64 AtNs) {
+	const ma_uint64 epoch = static_cast<ma_uint16>(Snapshot.s_epoch);
+	const ma_uint64 frame = std::min(static_cast<ma_uint64>(AudioBuffering::HeardFrame(Snapshot, AtNs) * FrameScale), FrameMask);
+
+	ma_uint64 last = p_last.load(std::memory_order_relaxed);
+	for (;;) {
+		const auto ahead = static_cast<ma_int16>(static_cast<ma_uint16>((last >> FrameBits) - epoch));
+		if (ahead > 0) {
+			return static_cast<double>(frame) / FrameScale; // Another reader is already past a seek or boundary this snapshot predates
+		}
+		if (ahead == 0 && (last & FrameMask) >= frame) {
+			return static_cast<double>(last & FrameMask) / FrameScale; // A late period, hold until the callback catches up
+		}
+		if (p_last.compare_exchange_weak(last, epoch << FrameBits | frame, std::memory_order_relaxed)) {
+			return static_cast<double>(frame) / FrameScale;
+		}
+	}
+}
+
+void AudioBuffering::SetDeviceLatencyMs(double Milliseconds) {
+	p_deviceLatencyFrames.store(static_cast<ma_uint32>(Milliseconds * p_outputSampleRate / 1000.0), std::memory_order_relaxed);
+}
+
+void AudioBuffering::SetPlaybackState(PlaybackState State) {
+	p_playbackState.store(State, std::memory_order_relaxed);
+	p_paused.store(State != PlaybackState::Playing, std::memory_order_relaxed);
+}
+
+void AudioBuffering::PostEvent(EngineEventType Type, ma_uint64 Frame) {
+	// Never blocks: if the controller is that far behind the event is dropped
+	p_events.Push({Type, p_generation.load(std::memory_order_relaxed), Frame});
+}
+
+ma_int64 AudioBuffering::NowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AudioBuffering::RequestSeek(ma_uint64 FrameIndex) {
+	p_seekTarget.store(FrameIndex, std::memory_order_relaxed);
+	p_seekRequestTimeNs.store(NowNs(), std::memory_order_relaxed);
+	p_seekPending.store(true, std::memory_order_release);
+
+	// Report the target right away, the callback confirms it when the flush lands
+	p_globalFrameCount.store(FrameIndex);
+	WakeFiller();
+}
+
+void AudioBuffering::PublishFlush(ma_uint64 Position) {
+	const ma_uint32 generation = p_flushGeneration.load(std::memory_order_relaxed);
+	p_flushGeneration.store(generation + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	p_flushIndex.store(p_ring.GetWriteIndex(), std::memory_order_relaxed);
+	p_flushPosition.store(Position, std::memory_order_relaxed);
+
+	p_flushGeneration.store(generation + 2, std::memory_order_release);
+}
+
+void AudioBuffering::ApplyFlush() {
+	const ma_uint32 generation = p_flushGeneration.load(std::memory_order_acquire);
+	if (generation == p_flushSeen || (generation & 1)) {
+		return; // Nothing new, or the filler is mid-publish (we retry next period)
+	}
+
+	const ma_uint64 index = p_flushIndex.load(std::memory_order_relaxed);
+	const ma_uint64 position = p_flushPosition.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (p_flushGeneration.load(std::memory_order_relaxed) != generation) {
+		return;
+	}
+
+	p_ring.DiscardTo(index);
+	p_globalFrameCount.store(position);
+	++p_clockEpoch;
+	p_flushSeen = generation;
+	p_awaitFirstSample = true;
+}
+
+void AudioBuffering::PrepareNext(ma_decoder *pNext, SeekIndex* pIndex, ma_uint64 LengthFrames, TrackId Track) {
+	// Runs on the controller thread, the filler never touches the preroll until the decoder is published
+	const auto prerollFrames = static_cast<ma_uint64>(p_outputSampleRate * PrerollSeconds);
+	p_preroll.resize(prerollFrames * p_ring.GetBytesPerFrame());
+
+	ma_uint64 framesRead = 0;
+	ma_decoder_read_pcm_frames(pNext, p_preroll.data(), prerollFrames, &framesRead);
+	p_prerollFrames = framesRead;
+	p_nextSeekIndex = pIndex;
+	p_nextLength = LengthFrames;
+	p_nextTrackId = Track;
+
+	p_nextDecoder.store(pNext, std::memory_order_release);
+	WakeFiller();
+}
+
+bool AudioBuffering::CancelNext() {
+	return p_nextDecoder.exchange(nullptr, std::memory_order_acq_rel) != nullptr;
+}
+
+void AudioBuffering::SetCrossfade(float Seconds, CrossfadeCurve Curve) {
+	p_crossfadeCurve.store(Curve);
+	p_crossfadeSeconds.store(std::max(Seconds, 0.0f));
+	WakeFiller();
+}
+
+void AudioBuffering::SetGapless(bool Enabled) {
+	p_gapless.store(Enabled);
+	WakeFiller();
+}
 
 void AudioBuffering::ResetBuffer() {
 	// Stop Filling thread
-	p_keepFilling = false;
-	if (p_bufferFillerThread.joinable()) {
-		p_bufferFillerThread.join();
-	}
+	StopFiller();
 
 	// Reset the player count
 	p_globalFrameCount.store(0);
 	p_keepFilling = true;
 
-	// Rest the buffer status
-	p_buffers[0].s_ready = false;
-	p_buffers[1].s_ready = false;
-	p_activeBuffer = 0;
-	p_globalFrameCount = 0;
+	// Both sides are stopped, drop everything including a queued or spliced next track
+	p_ring.Reset();
+	p_nextDecoder.store(nullptr);
+	p_boundaryFrame.store(NoBoundary);
+	p_endFrame.store(NoBoundary);
+	p_mixedEnd.store(0);
+	p_generation.fetch_add(1, std::memory_order_acq_rel); // Events still queued for the old stream are stale now
+	p_seekPending.store(false);
+	p_flushSeen = p_flushGeneration.load();
+	p_awaitFirstSample = false;
 }
 
-void AudioBuffering::CleaerBuffer() {
-    // Rest the buffer status
-    p_buffers[0].s_ready = false;
-    p_buffers[1].s_ready = false;
-    p_activeBuffer = 0;
-    p_globalFrameCount = 0;
-}
+void AudioBuffering::BufferFiller(ma_decoder *pDecoder, SeekIndex* pIndex, ma_uint64 LengthFrames, TrackId Track) {
+	// Decode in small chunks straight into the ring's free space, no scratch block and no extra copy
+	const auto chunkFrames = static_cast<ma_uint64>(p_outputSampleRate * ChunkSeconds);
+	const ma_uint32 bytesPerFrame = p_ring.GetBytesPerFrame();
+	const ma_uint32 channels = p_context.s_channels;
+	std::vector<ma_uint8> preroll; // Owned by the filler once swapped in at a splice
+	ma_uint64 prerollWritten = 0;
+	ma_uint64 prerollPending = 0;
+	ma_decoder* playing = pDecoder; // Decoder of the track being heard, differs from pDecoder after a splice
+	SeekIndex* playingIndex = pIndex;
+	ma_uint64 playingLength = LengthFrames;
+	TrackId playingTrackId = Track;
+	bool atEnd = false;
+
+	// Crossfade state, the scratch blocks are sized once here so mixing never allocates
+	ma_decoder* fadeNext = nullptr; // The incoming track while an overlap is being mixed
+	SeekIndex* fadeNextIndex = nullptr;
+	ma_uint64 fadeNextLength = 0;
+	TrackId fadeNextTrackId = 0;
+	ma_uint64 fadeFrames = 0;
+	ma_uint64 fadePosition = 0;
+	ma_uint64 fadeBoundary = 0;
+	CrossfadeCurve fadeCurve = CrossfadeCurve::EqualPower;
+	std::vector<float> head(chunkFrames * channels);
 
-void AudioBuffering::BufferFiller(ma_decoder *pDecoder) {
-	int nextBuffer = 0;
 	while (p_keepFilling) {
-		// 等待当前缓冲区消耗过半再填充
-		if (p_buffers[nextBuffer].s_ready) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		// The callback has played past the splice point, seeks now belong to the new track
+		if (playing != pDecoder && p_boundaryFrame.load(std::memory_order_acquire) == NoBoundary) {
+			playing = pDecoder;
+			playingIndex = pIndex;
+			playingLength = LengthFrames;
+			playingTrackId = Track;
+		}
+
+		// 处理跳转请求: 只有填充线程会操作解码器
+		if (p_seekPending.exchange(false, std::memory_order_acq_rel)) {
+			// Seeking during a crossfade: drop the overlap and put the incoming track back in the queue
+			if (fadeNext != nullptr) {
+				ma_decoder_seek_to_pcm_frame(fadeNext, 0);
+				p_prerollFrames = 0;
+				p_nextSeekIndex = fadeNextIndex;
+				p_nextLength = fadeNextLength;
+				p_nextTrackId = fadeNextTrackId;
+				p_nextDecoder.store(fadeNext, std::memory_order_release);
+				fadeNext = nullptr;
+			}
+
+			// Seeking back into a track we already spliced away from: hand the next one back
+			ma_uint64 boundary = p_boundaryFrame.load(std::memory_order_acquire);
+			if (playing != pDecoder && boundary != NoBoundary && p_boundaryFrame.compare_exchange_strong(boundary, NoBoundary, std::memory_order_acq_rel)) {
+				ma_decoder_seek_to_pcm_frame(pDecoder, 0);
+				p_prerollFrames = 0;
+				p_nextSeekIndex = pIndex;
+				p_nextLength = LengthFrames;
+				p_nextTrackId = Track;
+				p_nextDecoder.store(pDecoder, std::memory_order_release);
+				pDecoder = playing;
+				pIndex = playingIndex;
+				LengthFrames = playingLength;
+				Track = playingTrackId;
+			}
+			playing = pDecoder;
+			playingIndex = pIndex;
+			playingLength = LengthFrames;
+			playingTrackId = Track;
+			prerollPending = 0;
+
+			const ma_uint64 target = p_seekTarget.load(std::memory_order_relaxed);
+			if (pIndex != nullptr) {
+				pIndex->Seek(pDecoder, target);
+			} else {
+				ma_decoder_seek_to_pcm_frame(pDecoder, target);
+			}
+			p_endFrame.store(NoBoundary, std::memory_order_release); // The end moves away again
+			PublishFlush(target);
+			atEnd = false;
+		}
+
+		// 到达高水位(或没有空间)后休眠, 直到回调越过低水位再唤醒
+		if (p_ring.AvailableRead() >= GetHighWatermark() || p_ring.AvailableWrite() < chunkFrames) {
+			WaitForRefill();
+			continue;
+		}
+
+		// 交叉淡入淡出: decode the tail straight into the ring and the head into scratch, mix in place
+		if (fadeNext != nullptr) {
+			const RingBuffer::WriteRegion region = p_ring.AcquireWrite(std::min(chunkFrames, fadeFrames - fadePosition));
+			const ma_uint64 frames = region.s_frames;
+			auto* tail = static_cast<float*>(region.s_data);
+
+			ma_uint64 tailRead = 0;
+			ma_decoder_read_pcm_frames(pDecoder, tail, frames, &tailRead);
+			std::fill(tail + tailRead * channels, tail + frames * channels, 0.0f);
+
+			// The head starts with what is left of the next track's preroll
+			const ma_uint64 fromPreroll = std::min(frames, prerollPending);
+			memcpy(head.data(), preroll.data() + prerollWritten * bytesPerFrame, fromPreroll * bytesPerFrame);
+			prerollWritten += fromPreroll;
+			prerollPending -= fromPreroll;
+			ma_uint64 headRead = 0;
+			if (frames > fromPreroll) {
+				ma_decoder_read_pcm_frames(fadeNext, head.data() + fromPreroll * channels, frames - fromPreroll, &headRead);
+			}
+			std::fill(head.data() + (fromPreroll + headRead) * channels, head.data() + frames * channels, 0.0f);
+
+			// The gain stage ramps both gains between the curve's values at the ends of each segment: a linear
+			// curve in one go, equal power every FadeSegmentFrames (from a 0.1 s overlap up, under 0.001 dB off the exact curve)
+			const ma_uint64 segment = fadeCurve == CrossfadeCurve::Linear ? frames : FadeSegmentFrames;
+			for (ma_uint64 i = 0; i < frames; i += segment) {
+				const ma_uint64 count = std::min(segment, frames - i);
+				const float from = static_cast<float>(fadePosition + i) / static_cast<float>(fadeFrames);
+				const float to = static_cast<float>(fadePosition + i + count) / static_cast<float>(fadeFrames);
+				GainStage::Mix(tail + i * channels, head.data() + i * channels, count, channels,
+							   FadeOutGain(fadeCurve, from), FadeOutGain(fadeCurve, to),
+							   FadeInGain(fadeCurve, from), FadeInGain(fadeCurve, to));
+			}
+			p_ring.CommitWrite(frames);
+			p_mixedEnd.store(p_ring.GetWriteIndex(), std::memory_order_release);
+			fadePosition += frames;
+
+			if (fadePosition >= fadeFrames) {
+				// The incoming track carries on alone. The boundary goes out only now so the controller can't
+				// release the outgoing decoder mid-overlap; the callback derives the new position from how far
+				// past it has already read, so a late boundary is still sample accurate.
+				pDecoder = fadeNext;
+				pIndex = fadeNextIndex;
+				LengthFrames = fadeNextLength;
+				Track = fadeNextTrackId;
+				fadeNext = nullptr;
+				atEnd = false;
+				p_boundaryLength.store(LengthFrames, std::memory_order_relaxed);
+				p_boundaryTrackId.store(Track, std::memory_order_relaxed);
+				p_boundaryFrame.store(fadeBoundary, std::memory_order_release);
+			}
 			continue;
 		}
 
-		// 计算需要读取的帧数
-		const ma_uint32 targetFrames = p_outputSampleRate * 0.5f;
-		p_buffers[nextBuffer].s_data.resize(targetFrames * ma_get_bytes_per_frame(pDecoder->outputFormat, pDecoder->outputChannels));
-
-		// 读取音频数据
-		ma_uint64 framesRead;
-		ma_result result = ma_decoder_read_pcm_frames(
-			pDecoder,
-			p_buffers[nextBuffer].s_data.data(),
-			targetFrames,
-			&framesRead
-		);
-
-		if (result == MA_SUCCESS && framesRead > 0) {
-			p_buffers[nextBuffer].s_startFrame = p_globalFrameCount;
-			p_buffers[nextBuffer].s_totalFrames = framesRead;
-			p_buffers[nextBuffer].s_ready = true;
-			nextBuffer = (nextBuffer + 1) % 2;
-		} else {
-			// Error something should be here...
-			break;
+		// A freshly spliced track starts with its pre-decoded head
+		if (prerollPending > 0) {
+			const ma_uint64 written = p_ring.Write(preroll.data() + prerollWritten * bytesPerFrame, prerollPending);
+			prerollWritten += written;
+			prerollPending -= written;
+			continue;
+		}
+
+		// End of the track: wait for a seek, a next track or a stop instead of leaving the thread
+		if (atEnd) {
+			// Splicing withdraws the end marker. If the callback has already played up to it, the controller
+			// was told the track ended and replaces this stream, so the queued track is left alone.
+			ma_uint64 end = p_endFrame.load(std::memory_order_acquire);
+			ma_decoder* next = p_gapless && end != NoBoundary ? p_nextDecoder.exchange(nullptr, std::memory_order_acq_rel) : nullptr;
+			if (next != nullptr && !p_endFrame.compare_exchange_strong(end, NoBoundary, std::memory_order_acq_rel)) {
+				p_nextDecoder.store(next, std::memory_order_release);
+				next = nullptr;
+			}
+			if (next == nullptr) {
+				WaitForWork(p_endFrame.load(std::memory_order_acquire) != NoBoundary);
+				continue;
+			}
+
+			// Gapless: splice the queued track right behind the last frame we wrote.
+			// Take the preroll before publishing the boundary: the controller only prepares the
+			// following track after the callback has played past this boundary.
+			preroll.swap(p_preroll);
+			prerollWritten = 0;
+			prerollPending = p_prerollFrames;
+			pDecoder = next;
+			pIndex = p_nextSeekIndex;
+			LengthFrames = p_nextLength;
+			Track = p_nextTrackId;
+			atEnd = false;
+			p_boundaryLength.store(LengthFrames, std::memory_order_relaxed);
+			p_boundaryTrackId.store(Track, std::memory_order_relaxed);
+			p_boundaryFrame.store(p_ring.GetWriteIndex(), std::memory_order_release);
+			continue;
+		}
+
+		// Crossfade: stop decoding exactly where the overlap begins, then take the queued track.
+		// Not while an earlier splice is still unheard, there is only one queue slot to hand things back to.
+		ma_uint64 wanted = chunkFrames;
+		const auto crossfadeFrames = static_cast<ma_uint64>(p_outputSampleRate * p_crossfadeSeconds.load(std::memory_order_relaxed));
+		if (crossfadeFrames > 0 && LengthFrames > 0 && p_context.s_floatSamples && p_gapless && playing == pDecoder && HasNext()) {
+			const ma_uint64 fadeStart = LengthFrames > crossfadeFrames ? LengthFrames - crossfadeFrames : 0;
+			ma_uint64 cursor = 0;
+			ma_decoder_get_cursor_in_pcm_frames(pDecoder, &cursor);
+
+			if (cursor < fadeStart) {
+				wanted = std::min(wanted, fadeStart - cursor);
+			} else if (cursor < LengthFrames) {
+				fadeNext = p_nextDecoder.exchange(nullptr, std::memory_order_acq_rel);
+				if (fadeNext != nullptr) {
+					fadeNextIndex = p_nextSeekIndex;
+					fadeNextLength = p_nextLength;
+					fadeNextTrackId = p_nextTrackId;
+					preroll.swap(p_preroll);
+					prerollWritten = 0;
+					prerollPending = p_prerollFrames;
+					fadeFrames = LengthFrames - cursor; // Shorter when crossfade was turned on late
+					fadePosition = 0;
+					fadeBoundary = p_ring.GetWriteIndex();
+					fadeCurve = p_crossfadeCurve.load();
+					continue;
+				}
+			}
+		}
+
+		// 读取音频数据: the region stops at the end of the storage, the next pass continues from slot 0
+		const RingBuffer::WriteRegion region = p_ring.AcquireWrite(wanted);
+		ma_uint64 framesRead = 0;
+		ma_result result = ma_decoder_read_pcm_frames(pDecoder, region.s_data, region.s_frames, &framesRead);
+		p_ring.CommitWrite(framesRead);
+
+		// End of file or decoder error: mark the exact ring index the track stops at, and say so right away
+		atEnd = result != MA_SUCCESS || framesRead == 0;
+		if (atEnd) {
+			const ma_uint64 end = p_ring.GetWriteIndex();
+			p_endFrame.store(end, std::memory_order_release);
+			PostEvent(EngineEventType::DecodeEnded, end);
 		}
 	}
 }
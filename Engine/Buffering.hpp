@@ -1,6 +1,6 @@
 /*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
  *  File Name: Buffering.hpp
- *  Lib: Beeplayer Core engine Audio Buffer definitions -> Double buffering lib
+ *  Lib: Beeplayer Core engine Audio Buffer definitions -> Ring buffering lib
  *  Author: Romi Brooks
  *  Date: 2025-04-24
  *  Type: Buffers, Core Engine
@@ -11,50 +11,252 @@
 
 // Standard Lib
 #include <atomic>
-#include <thread>
+#include <limits>
 #include <vector>
 
 // Basic Lib
 #include "../miniaudio/miniaudio.h"
+#include "DecodeService.hpp"
+#include "EventQueue.hpp"
+#include "LatencyProfile.hpp"
+#include "RingBuffer.hpp"
+#include "SeekIndex.hpp"
+#include "Seqlock.hpp"
+#include "../FileSystem/TrackStore.hpp"
+
+class AudioBuffering;
+
+// Gain curves of a crossfade, t runs 0 -> 1 across the overlap
+enum class CrossfadeCurve {
+	Linear,     // out = 1 - t, in = t (constant amplitude, dips in loudness mid-way)
+	EqualPower, // out = cos(t * pi/2), in = sin(t * pi/2) (constant power)
+};
+
+enum class PlaybackState : ma_uint8 {
+	Stopped,
+	Playing,
+	Paused,
+};
+
+// What is being heard right now, published by data_callback once per period (and by StartFiller()
+// while the callback is stopped). Position, length and track change together at a gapless boundary.
+// s_frame is what has been handed to the device at s_timeNs, AudioBuffering::HeardFrame() turns it
+// into what is coming out of the speaker at any instant.
+struct PlaybackSnapshot {
+	ma_uint64 s_frame = 0;        // 当前曲目内已交给设备的帧数
+	ma_uint64 s_totalFrames = 0;  // 当前曲目总帧数, 0 = unknown
+	ma_int64 s_timeNs = 0;        // steady_clock time of the callback that published this
+	ma_uint32 s_sampleRate = 0;
+	ma_uint32 s_latencyFrames = 0; // 设备缓冲 (period size * periods), in output frames
+	ma_uint32 s_bufferedFrames = 0; // 环形缓冲区中已解码待播放的帧数
+	TrackId s_trackId = 0;        // Whatever id the controller handed to StartFiller() / PrepareNext()
+	ma_uint32 s_epoch = 0;        // Changes where the position may jump back: a seek landing, a track boundary, a new stream
+	PlaybackState s_state = PlaybackState::Stopped;
+};
+
+// The playhead clock as readers see it. AudioBuffering::HeardFrame() re-anchors on every snapshot, so it steps
+// back when a period comes late; this one never returns less than it already did within one s_epoch.
+// Any number of threads may read through the same clock.
+class PlayheadClock {
+	public:
+		double HeardFrame(const PlaybackSnapshot& Snapshot, ma_int64 AtNs);
+		void Reset() { p_last.store(0, std::memory_order_relaxed); } // Before a new AudioBuffering publishes, its epochs restart
+
+	private:
+		// Epoch (16 bits) | frame in 1/256 frames (48 bits): one CAS, and what is returned is exactly what is stored
+		static constexpr int FrameBits = 48;
+		static constexpr ma_uint64 FrameMask = (ma_uint64(1) << FrameBits) - 1;
+		static constexpr double FrameScale = 256.0;
+		std::atomic<ma_uint64> p_last{0};
+};
+
+// Everything data_callback touches, resolved once per stream in StartFiller().
+// The device's pUserData points at this, so each stream (and each device) has its own cursor.
+struct StreamContext {
+	RingBuffer* s_ring = nullptr;        // 环形缓冲区
+	AudioBuffering* s_owner = nullptr;   // 所属的缓冲管理器
+	ma_uint32 s_bytesPerFrame = 0;       // 每帧字节数(只在建流时计算一次)
+	ma_uint32 s_channels = 0;
+	bool s_floatSamples = false;         // The gain stage only runs on f32 (the engine's output format)
+};
 
 class AudioBuffering {
 	public:
-		struct Buffer {
-			std::vector<ma_uint8> s_data; // 原始音频数据
-			ma_uint64 s_startFrame = 0; // 缓冲区起始帧位置
-			ma_uint64 s_totalFrames = 0; // 缓冲区总帧数
-			std::atomic<bool> s_ready{false}; // 缓冲区就绪状态
-		};
+		static constexpr float DefaultRingSeconds = 1.0f;    // 环形缓冲区容量(秒)
+		static constexpr float ChunkSeconds = 0.02f;  // 每次解码的块大小(秒)
+		static constexpr float DefaultLowWatermarkSeconds = 0.25f;  // 低于此水位时唤醒填充线程
+		static constexpr float DefaultHighWatermarkSeconds = 0.9f;  // 填充到此水位后休眠
+		static constexpr float PrerollSeconds = 0.1f;  // 无缝播放时提前解码的下一首开头
+		static constexpr float VolumeRampSeconds = 0.01f; // 音量变化的平滑时长
+		static constexpr float PauseFadeSeconds = 0.02f;  // 暂停/恢复的淡出淡入时长
+		static constexpr ma_uint64 NoBoundary = std::numeric_limits<ma_uint64>::max();
+		static constexpr size_t EventCapacity = 64;
 
-	    explicit AudioBuffering(ma_decoder *decoder);
+		using EngineEvents = EventQueue<EngineEvent, EventCapacity>;
+
+	    AudioBuffering() = default; // Idle until StartFiller()
+	    explicit AudioBuffering(ma_decoder *decoder, SeekIndex* index = nullptr, ma_uint64 lengthFrames = 0);
 
 	    ~AudioBuffering();
 
-		void BufferFiller(ma_decoder* pDecoder);
+		// The optional SeekIndex travels with its decoder and speeds up MP3 seeks once built.
+		// LengthFrames (0 = unknown) is what a crossfade measures its start from.
+		// Track only travels into the PlaybackSnapshot.
+		void BufferFiller(ma_decoder* pDecoder, SeekIndex* pIndex, ma_uint64 LengthFrames, TrackId Track);
+		void StartFiller(ma_decoder* pDecoder, SeekIndex* pIndex = nullptr, ma_uint64 LengthFrames = 0, TrackId Track = 0); // 按解码器格式准备环形缓冲区并提交填充任务
+		void StopFiller(); // Returns once the filler job has finished, safe to call any number of times
+
+		// Gapless playback
+		// PrepareNext() pre-decodes the head of the next track and queues it, the filler splices it
+		// into the ring when the current decoder hits the end. The next decoder must already output
+		// the same format, channels and rate as the current one.
+		void PrepareNext(ma_decoder* pNext, SeekIndex* pIndex = nullptr, ma_uint64 LengthFrames = 0, TrackId Track = 0);
+		bool CancelNext(); // true if the queued decoder was not spliced yet
+		bool HasNext() const { return p_nextDecoder.load(std::memory_order_acquire) != nullptr; }
+		void SetGapless(bool Enabled);
+		bool IsGapless() const { return p_gapless.load(); }
+		// The current track's last frame is in the ring and nothing is spliced behind it (yet)
+		bool IsEndDecoded() const { return p_endFrame.load(std::memory_order_acquire) != NoBoundary; }
+
+		// Crossfade (needs gapless and a prepared next track): the last Seconds of the current track
+		// are mixed with the head of the next one, starting exactly Seconds before the end. 0 turns it off.
+		void SetCrossfade(float Seconds, CrossfadeCurve Curve);
+		float GetCrossfadeSeconds() const { return p_crossfadeSeconds.load(); }
+		CrossfadeCurve GetCrossfadeCurve() const { return p_crossfadeCurve.load(); }
+
+		// Seeking
+		// Any thread may request a seek, only the filler touches the decoder. The filler seeks,
+		// then publishes a flush (ring index + new position) that data_callback applies before its
+		// next read, so no stale audio is played. Requests are latest-wins.
+		void RequestSeek(ma_uint64 FrameIndex);
+		void ApplyFlush(); // data_callback only
+		double GetLastSeekLatencyMs() const { return p_lastSeekLatencyNs.load(std::memory_order_acquire) / 1e6; }
+		ma_uint32 GetCompletedSeeks() const { return p_seeksCompleted.load(std::memory_order_acquire); }
+
+		// Engine events (end of decode, end of track heard, boundary passed, seek landed), pushed by the
+		// filler and data_callback the moment they happen, drained by the controller.
+		// GetStreamGeneration() changes on every ResetBuffer(), events stamped with an older one are stale.
+		EngineEvents& GetEvents() { return p_events; }
+		ma_uint32 GetStreamGeneration() const { return p_generation.load(std::memory_order_acquire); }
+
+		// Wait-free for the writer, readers retry only while a period is being published
+		PlaybackSnapshot GetSnapshot() const { return p_snapshot.Load(); }
+		void PublishSnapshot(); // data_callback only
+		// Playhead clock: the frame leaving the speaker at AtNs (fractional), from any thread. Subtracts the
+		// device buffer and interpolates from the callback's timestamp, never past what the device has been handed.
+		// Stateless, so it may step back between snapshots: readers go through a PlayheadClock.
+		static double HeardFrame(const PlaybackSnapshot& Snapshot, ma_int64 AtNs);
+		static ma_int64 NowNs(); // steady_clock, the clock snapshots are stamped with
+		// The device's buffer as opened, set after (re)opening it while the callback is stopped
+		void SetDeviceLatencyMs(double Milliseconds);
 
 		// Getter
-		Buffer* GetBuffers() { return p_buffers; }
-		std::thread& GetBufferThread() { return p_bufferFillerThread; }
-		int GetActiveBuffer() const { return p_activeBuffer.load(); }
+		RingBuffer& GetRing() { return p_ring; }
+		StreamContext& GetStreamContext() { return p_context; }
+		bool IsFilling() const { return !p_fillerJob.IsDone(); }
 		ma_uint64 GetGlobalFrameCount() const { return p_globalFrameCount.load(); }
 		ma_uint32 GetOutputSampleRate() const { return p_outputSampleRate; }
+		ma_uint64 GetLowWatermark() const { return p_lowWatermark.load(std::memory_order_relaxed); }
+		ma_uint64 GetHighWatermark() const { return p_highWatermark.load(std::memory_order_relaxed); }
 
-		void SwitchBuffer();
-		void ConsumeFrames(ma_uint64 frames) { p_globalFrameCount += frames; }
+		void ConsumeFrames(ma_uint64 frames);
 
 		void SetGlobalFrameCount(ma_uint64 frames) { p_globalFrameCount.store(frames); }
 		void SetOutputSampleRate(ma_uint32 rate) { p_outputSampleRate = rate; }
+		void SetWatermarks(float LowSeconds, float HighSeconds);
+		// Ring capacity and watermarks from a profile, the capacity takes effect on the next StartFiller()
+		void ApplyLatencyProfile(const LatencyProfile& Profile);
+
+		// Called from data_callback once the readable frames drop to the low watermark
+		void RequestRefill();
+
+		// Output gain and pause, applied in data_callback by the SIMD gain stage. Changes are ramped
+		// sample by sample across VolumeRampSeconds / PauseFadeSeconds, possibly spanning several periods.
+		// Pausing keeps the device running: once faded out the callback outputs silence and leaves the ring alone.
+		void SetGain(float Gain) { p_targetGain.store(Gain, std::memory_order_relaxed); }
+		float GetGain() const { return p_targetGain.load(std::memory_order_relaxed); }
+		void SetPaused(bool Paused) { SetPlaybackState(Paused ? PlaybackState::Paused : PlaybackState::Playing); }
+		void SetPlaybackState(PlaybackState State); // Stopped holds the output like Paused
+		bool IsPaused() const { return p_paused.load(std::memory_order_relaxed); }
+		bool HoldOutput() const; // data_callback only: paused and fully faded out
+		void ApplyGain(float* Samples, ma_uint64 Frames); // data_callback only
 
 		void ResetBuffer();
-             void CleaerBuffer();
 
 	private:
-		Buffer p_buffers[2];            // 双缓冲数组
-		std::atomic<int> p_activeBuffer{0};  // 当前活动缓冲区索引
+		RingBuffer p_ring;                   // SPSC 环形缓冲区
+		StreamContext p_context;             // 回调上下文
 		std::atomic<ma_uint64> p_globalFrameCount{0}; // 全局已播放帧数
 		ma_uint32 p_outputSampleRate = 0;    // 采样率（需初始化时获取）
-		std::thread p_bufferFillerThread;    // 缓冲填充线程
-		std::atomic<bool> p_keepFilling{true}; // 线程控制标志
+		DecodeService::Job p_fillerJob;      // 缓冲填充任务 (runs on the decode service at Stream priority)
+		std::atomic<bool> p_keepFilling{true}; // 填充控制标志
+
+		float p_ringSeconds = DefaultRingSeconds;
+
+		// Refill signalling, the filler blocks on p_refillSignal instead of polling
+		float p_lowWatermarkSeconds = DefaultLowWatermarkSeconds;
+		float p_highWatermarkSeconds = DefaultHighWatermarkSeconds;
+		std::atomic<ma_uint64> p_lowWatermark{0};   // Frames
+		std::atomic<ma_uint64> p_highWatermark{0};  // Frames
+		std::atomic<ma_uint32> p_refillSignal{0};
+		std::atomic<bool> p_fillerWaiting{false};
+
+		// Gapless splice state
+		std::atomic<bool> p_gapless{false};
+		std::atomic<ma_decoder*> p_nextDecoder{nullptr};  // Queued by PrepareNext(), taken by the filler
+		SeekIndex* p_nextSeekIndex = nullptr;              // Published together with p_nextDecoder
+		ma_uint64 p_nextLength = 0;                        // Published together with p_nextDecoder
+		TrackId p_nextTrackId = 0;                         // Published together with p_nextDecoder
+		std::vector<ma_uint8> p_preroll;                   // Head of the queued track
+		ma_uint64 p_prerollFrames = 0;
+		std::atomic<ma_uint64> p_boundaryFrame{NoBoundary}; // Ring index where the spliced track begins
+		std::atomic<ma_uint64> p_boundaryLength{0};         // Length and id of that track, published with it
+		std::atomic<TrackId> p_boundaryTrackId{0};
+		std::atomic<ma_uint64> p_endFrame{NoBoundary};      // Ring index after the last frame when nothing is spliced behind it
+		std::atomic<ma_uint64> p_mixedEnd{0};               // Ring index after the last crossfaded frame, those may exceed full scale
+		std::atomic<float> p_crossfadeSeconds{0.0f};
+		std::atomic<CrossfadeCurve> p_crossfadeCurve{CrossfadeCurve::EqualPower};
+
+		// Seek mailbox (any thread -> filler)
+		std::atomic<bool> p_seekPending{false};
+		std::atomic<ma_uint64> p_seekTarget{0};
+		std::atomic<ma_int64> p_seekRequestTimeNs{0};
+
+		// Flush publication (filler -> callback), a seqlock: odd generation means a write is in progress
+		std::atomic<ma_uint32> p_flushGeneration{0};
+		std::atomic<ma_uint64> p_flushIndex{0};     // Everything before this ring index is stale
+		std::atomic<ma_uint64> p_flushPosition{0};  // Track position of the first fresh frame
+		ma_uint32 p_flushSeen = 0;                   // Callback side
+		bool p_awaitFirstSample = false;             // Callback side, measuring seek latency
+		std::atomic<ma_int64> p_lastSeekLatencyNs{0};  // Request -> first fresh frame handed to the device
+		std::atomic<ma_uint32> p_seeksCompleted{0};
+
+		// Playback snapshot
+		Seqlock<PlaybackSnapshot> p_snapshot;
+		std::atomic<PlaybackState> p_playbackState{PlaybackState::Stopped};
+		ma_uint64 p_playingLength = 0;               // Callback side, length of the track being heard
+		TrackId p_playingTrackId = 0;                // Callback side
+		ma_uint32 p_clockEpoch = 0;                  // Callback side, see PlaybackSnapshot::s_epoch
+		std::atomic<ma_uint32> p_deviceLatencyFrames{0};
+
+		// Engine events
+		EngineEvents p_events;
+		std::atomic<ma_uint32> p_generation{0};
+
+		// Gain stage
+		std::atomic<float> p_targetGain{1.0f};
+		std::atomic<bool> p_paused{false};
+		float p_currentGain = 1.0f;                  // Callback side, gain at the start of the next frame
+		float p_rampTarget = 1.0f;                   // Callback side, where the running ramp ends
+		ma_uint64 p_rampRemaining = 0;               // Callback side, frames left in the running ramp
+		bool p_rampPaused = false;                   // Callback side, pause state the ramp was started for
+
+		void UpdateWatermarks();
+		void WaitForRefill();
+		void WaitForWork(bool TakesNext);
+		void WakeFiller();
+		void PublishFlush(ma_uint64 Position);
+		void PostEvent(EngineEventType Type, ma_uint64 Frame);
 };
 
 #endif //BUFFERING_HPP
@@ -7,12 +7,16 @@
  */
 
 #include "Controller.hpp"
+
+// Standard Lib
+#include <algorithm>
+
 #include "../Engine/DataCallback.hpp"
 #include "../Log/LogSystem.hpp"
 
-PlayerController::PlayerController() {
-    // 获取设备单例
-    Device = &AudioDevice::GetDeviceInstance();
+PlayerController::PlayerController(OutputSink* sink) {
+    // 没有指定输出时使用设备单例
+    Device = sink ? sink : &AudioDevice::GetDeviceInstance();
 }
 
 PlayerController::~PlayerController() {
@@ -20,37 +24,65 @@ PlayerController::~PlayerController() {
 }
 
 bool PlayerController::Initialize(const std::string& rootPath) {
-    std::lock_guard<std::mutex> lock(audioMutex);
+    // From here on commands queue up for the engine thread. What was posted while idle (settings
+    // given before Initialize(), or after a Cleanup()) applies now, before the engine is built.
+    stage = EngineStage::Starting;
+    Command command;
+    while (commands.Pop(command)) {
+        ExecuteCommand(command);
+    }
 
+    // The engine thread is not running yet, everything below is ours
     try {
         // 创建路径对象
-        Pather = std::make_unique<Path>(rootPath);
+        Pather = std::make_unique<Path>(rootPath, scanBatchCallback);
 
         // 获取媒体文件列表
-        tracks = Pather->GetFiles();
-        if (tracks.empty()) {
+        PublishTracks();
+        if (tracks->Empty()) {
             Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_CONTROLLER, "No media files found!");
-            return false;
+            return AbortInitialize();
         }
 
         // 初始化音频组件
         if (!InitializeAudioComponents()) {
-            return false;
+            return AbortInitialize();
         }
+        ScheduleReadAhead();
+        RequestPrepareNext();
 
-        // 启动监控线程
+        // 启动引擎线程, from here on only it touches the audio objects. It publishes the state first,
+        // then runs what was queued meanwhile. Running goes first: a command pushed after that wakes it,
+        // one pushed before is in the queue when it starts.
         running = true;
-        nextCheckThread = std::thread(&PlayerController::NextFileCheckThread, this);
-
         initialized = true;
+        stage = EngineStage::Running;
+        engineThread = std::thread(&PlayerController::EngineThread, this);
+
+        // Follow the folder from now on. A list that came from the index is reconciled first, in the background.
+        Watcher = std::make_unique<LibraryWatcher>(Pather->Root(), [this](LibraryChanges changes) {
+            OnLibraryChanged(std::move(changes));
+        });
+        Watcher->Start(Pather->LoadedFromIndex());
         return true;
     } catch (const std::exception& e) {
         Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_CONTROLLER,
                    "Initialization error: " + std::string(e.what()));
-        return false;
+        return AbortInitialize();
     }
 }
 
+bool PlayerController::AbortInitialize() {
+    // No engine thread came up: what was queued meanwhile runs here, as it would have before Initialize()
+    Command command;
+    while (commands.Pop(command)) {
+        ExecuteCommand(command);
+    }
+    stage = EngineStage::Idle;
+    PublishState();
+    return false;
+}
+
 bool PlayerController::InitializeAudioComponents() {
     try {
         // 创建解码器
@@ -64,10 +96,19 @@ bool PlayerController::InitializeAudioComponents() {
 
         // 创建状态计时器和缓冲区
         Timer = std::make_unique<Status>(*Decoder);
-        Buffer = std::make_unique<AudioBuffering>(&Decoder->GetDecoder());
+        const LatencyProfile& profile = GetLatencyProfile(latencyMode);
+        Buffer = std::make_unique<AudioBuffering>();
+        playhead.Reset();
+        Buffer->ApplyLatencyProfile(profile);
+        Buffer->StartFiller(&Decoder->GetDecoder(), Decoder->GetSeekIndex(), Decoder->GetLengthInFrames(),
+                            Pather->CurrentTrackId());
+        Buffer->SetGapless(gapless);
+        Buffer->SetCrossfade(crossfadeSeconds, crossfadeCurve);
+        Buffer->SetGain(volume);
 
         // 初始化设备
-        Player->InitDevice(*Decoder, *Device, data_callback, *Buffer);
+        Player->InitDevice(*Device, data_callback, *Buffer, profile);
+        deviceLatencyMs = Device->GetLatencyMs();
 
         return true;
     } catch (const std::exception& e) {
@@ -78,16 +119,34 @@ bool PlayerController::InitializeAudioComponents() {
 }
 
 void PlayerController::Cleanup() {
+    // No more library changes, then commands still queued are dropped, the engine thread finishes the one it is running
+    Watcher.reset();
+    // Commands posted from now until the teardown is done are dropped too. One that got past the
+    // check may still be waking the engine thread, let it finish before anything goes away.
+    stage = EngineStage::Stopping;
+    while (posting.load() != 0) {
+        std::this_thread::yield();
+    }
     running = false;
-    if (nextCheckThread.joinable()) nextCheckThread.join();
-    if (playThread.joinable()) playThread.join();
-
-    std::lock_guard<std::mutex> lock(audioMutex);
+    if (Buffer) Buffer->GetEvents().Wake(); // let the engine thread see the flag
+    if (engineThread.joinable()) engineThread.join();
+    Command dropped;
+    while (commands.Pop(dropped)) {
+    }
 
     if (initialized) {
+        // 先停止填充线程, 再释放解码器
+        if (Buffer) {
+            Buffer->StopFiller();
+        }
         if (Player && Device && Decoder) {
             Player->Exit(*Device, *Decoder);
         }
+        DropNextTrack();
+        for (auto& [path, job] : readAheadJobs) {
+            job.CancelAndWait();
+        }
+        readAheadJobs.clear();
 
         // 释放资源（智能指针会自动管理）
         Pather.reset();
@@ -97,75 +156,317 @@ void PlayerController::Cleanup() {
         Buffer.reset();
 
         initialized = false;
+        isPlaying = false;
+        deviceLatencyMs = 0.0;
+        PublishState();
     }
+
+    stage = EngineStage::Idle;
 }
 
-void PlayerController::NextFileCheckThread() {
+void PlayerController::EngineThread() {
+	// Buffer lives until Cleanup() has joined this thread. Commands wake us through the event
+	// queue's signal too, so there is a single place to sleep on.
+	AudioBuffering::EngineEvents& events = Buffer->GetEvents();
+	PublishState(); // The state Initialize() left, from the one thread that writes it from now on
+
 	while (running) {
-		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+		// Read the signal before draining, a push after the last Pop() then ends the wait at once
+		const ma_uint32 seen = events.GetSignal();
+		Command command;
+		while (running && commands.Pop(command)) {
+			ExecuteCommand(command);
+			PublishState();
+		}
+		EngineEvent event;
+		while (running && events.Pop(event)) {
+			HandleEngineEvent(event);
+			PublishState();
+		}
+		if (running) {
+			events.Wait(seen);
+		}
+	}
+}
 
-		if (initialized) {
+void PlayerController::PostCommand(const Command& command) {
+	// Counted before the stage is read: Cleanup() either sees us here, or we see Stopping
+	posting.fetch_add(1);
+	if (stage.load() == EngineStage::Stopping) {
+		posting.fetch_sub(1);
+		return;
+	}
 
-			// 检查歌曲是否结束
-			if (Timer && Decoder && Buffer) {
-				const auto currentTime = Buffer->GetGlobalFrameCount() / Decoder->GetDecoder().outputSampleRate;
-				const auto totalTime = Timer->GetTotalFrames() / Decoder->GetDecoder().outputSampleRate;
+	if (!commands.Push(command)) {
+		Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_CONTROLLER, "Command queue full, dropped a command.");
+	} else if (stage.load() == EngineStage::Running) {
+		// Read again after the push: if Initialize() had not flipped to Running yet, the engine thread
+		// starts after it and finds the command. Idle / Starting: Initialize() or the engine thread drains it.
+		Buffer->GetEvents().Wake();
+	}
+	posting.fetch_sub(1);
+}
 
-				if (totalTime > 0 && currentTime >= totalTime) {
-					Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_CONTROLLER, "End of track, switching to next...");
-                                Next();
-				}
-			}
+void PlayerController::ExecuteCommand(const Command& command) {
+	switch (command.s_type) {
+		case CommandType::Play: PlayNow(); break;
+		case CommandType::Pause: PauseNow(); break;
+		case CommandType::Stop: StopNow(); break;
+		case CommandType::Next: NextNow(); break;
+		case CommandType::Prev: PrevNow(); break;
+		case CommandType::Switch: SwitchNow(command.s_index); break;
+		case CommandType::Seek: SeekNow(command.s_value); break;
+		case CommandType::SetVolume: SetVolumeNow(static_cast<float>(command.s_value)); break;
+		case CommandType::SetGapless: SetGaplessNow(command.s_index != 0); break;
+		case CommandType::SetCrossfade:
+			SetCrossfadeNow(static_cast<float>(command.s_value), static_cast<CrossfadeCurve>(command.s_index));
+			break;
+		case CommandType::SetLatencyProfile: SetLatencyProfileNow(static_cast<LatencyMode>(command.s_index)); break;
+		case CommandType::ApplyLibraryChanges: ApplyLibraryChangesNow(); break;
+	}
+}
 
-			// 重置跳转状态（如果超过500ms）
-			auto now = std::chrono::steady_clock::now();
-			if (isSeeking.load() && (now - lastSeekTime) > std::chrono::milliseconds(500)) {
-				isSeeking.store(false);
+void PlayerController::PublishState() {
+	ControllerState snapshot;
+	snapshot.s_track = currentTrack;
+	snapshot.s_playing = isPlaying;
+	snapshot.s_gapless = gapless;
+	snapshot.s_volume = volume;
+	snapshot.s_crossfadeSeconds = crossfadeSeconds;
+	snapshot.s_latencyMode = latencyMode;
+	snapshot.s_deviceLatencyMs = deviceLatencyMs;
+	state.Store(snapshot);
+}
+
+void PlayerController::HandleEngineEvent(const EngineEvent& event) {
+	// Events of a stream that was switched away from or rebuilt meanwhile don't apply any more
+	if (!initialized || !Buffer || event.s_generation != Buffer->GetStreamGeneration()) {
+		return;
+	}
+
+	switch (event.s_type) {
+		// 无缝播放: 回调已越过拼接点, 切换到预解码的曲目并为下一首做准备
+		case EngineEventType::TrackAdvanced: {
+			AdvanceToPreparedTrack();
+			if (gapless && !NextDecoder && !nextUnavailable) {
+				PrepareNextTrack();
 			}
+			break;
+		}
+		// The decoder ran out (the ring still holds the tail), last chance to queue a gapless successor
+		case EngineEventType::DecodeEnded:
+		case EngineEventType::PrepareNext: {
+			if (gapless && !NextDecoder && !nextUnavailable) {
+				PrepareNextTrack();
+			}
+			break;
+		}
+		// 曲目的最后一帧已送出且没有拼接下一首: 切换到下一首
+		case EngineEventType::TrackEnded: {
+			Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_CONTROLLER, "End of track, switching to next...");
+			NextNow();
+			break;
+		}
+		case EngineEventType::SeekCompleted: {
+			isSeeking = false;
+			break;
 		}
 	}
 }
 
+void PlayerController::RequestPrepareNext() {
+	if (Buffer) {
+		Buffer->GetEvents().Push({EngineEventType::PrepareNext, Buffer->GetStreamGeneration(), 0});
+	}
+}
+
+void PlayerController::PrepareNextTrack() {
+    if (tracks->Empty()) {
+        nextUnavailable = true;
+        return;
+    }
+    auto next = std::make_unique<AudioDecoder>();
+
+    // Every decoder outputs the device format, so the next file's PCM can share the ring
+    const ma_decoder_config config = AudioDevice::DecoderConfig();
+    if (!next->InitDecoder(Pather->PeekNextFilePath(), &config)) {
+        nextUnavailable = true;
+        return;
+    }
+
+    preparedTrack = (currentTrack + 1) % tracks->Size();
+    Buffer->PrepareNext(&next->GetDecoder(), next->GetSeekIndex(), next->GetLengthInFrames(), tracks->Id(preparedTrack));
+    NextDecoder = std::move(next);
+    Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_CONTROLLER, "Prepared next track: ", Path::GetFileName(Pather->PeekNextFilePath()));
+}
+
+void PlayerController::ScheduleReadAhead() {
+    // Keep the jobs still inside the new window, cancel the rest (they only warm caches, nothing to undo)
+    std::vector<std::string> window;
+    const size_t count = std::min(ReadAheadTracks, tracks->Size() > 0 ? tracks->Size() - 1 : 0);
+    for (size_t ahead = 1; ahead <= count; ++ahead) {
+        window.push_back(Pather->PeekNextFilePath(ahead));
+    }
+
+    std::vector<std::pair<std::string, DecodeService::Job>> kept;
+    for (auto& [path, job] : readAheadJobs) {
+        if (std::ranges::find(window, path) != window.end()) {
+            kept.emplace_back(path, std::move(job));
+        } else {
+            job.Cancel();
+        }
+    }
+    for (const auto& path : window) {
+        const bool queued = std::ranges::any_of(kept, [&](const auto& entry) { return entry.first == path; });
+        if (!queued) {
+            kept.emplace_back(path, AudioDecoder::ReadAhead(path));
+        }
+    }
+    readAheadJobs = std::move(kept);
+}
+
+void PlayerController::AdvanceToPreparedTrack() {
+    if (!NextDecoder) return;
+
+    // The filler moved on to the next decoder before the boundary was played, the old one is idle.
+    // By index rather than NextFilePath(): the library may have changed since it was prepared.
+    Pather->SetIndex(preparedTrack);
+    std::swap(Decoder, NextDecoder);
+    DropNextTrack();
+    nextUnavailable = false;
+
+    Timer->SetFileLength(*Decoder);
+    Player->SetName(Path::GetFileName(Pather->CurrentFilePath()));
+    currentTrack = preparedTrack;
+    ScheduleReadAhead();
+    Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_CONTROLLER, "Gapless switch to track: ", currentTrack);
+    NotifyTrackChangedNow(currentTrack);
+}
+
+void PlayerController::DropNextTrack() {
+    if (NextDecoder) {
+        ma_decoder_uninit(&NextDecoder->GetDecoder());
+        NextDecoder.reset();
+    }
+}
+
+void PlayerController::SetGapless(bool enabled) {
+    PostCommand({CommandType::SetGapless, enabled ? 1u : 0u, 0.0});
+}
+
+void PlayerController::SetGaplessNow(bool enabled) {
+    gapless = enabled;
+    if (!Buffer) return;
+
+    Buffer->SetGapless(enabled);
+    // A track that is not spliced yet can go, a spliced one is finished by the normal advance
+    if (!enabled && Buffer->CancelNext()) {
+        DropNextTrack();
+    }
+    if (enabled) {
+        RequestPrepareNext();
+    }
+}
+
+void PlayerController::SetLatencyProfile(LatencyMode mode) {
+    PostCommand({CommandType::SetLatencyProfile, static_cast<size_t>(mode), 0.0});
+}
+
+void PlayerController::SetLatencyProfileNow(LatencyMode mode) {
+    latencyMode = mode;
+    if (!initialized || !Buffer || !Decoder) return; // Picked up by InitializeAudioComponents()
+
+    // The period size is fixed once the device is open, and the ring can only be resized while
+    // both sides are stopped: stop, rebuild both, and resume from the frame being heard.
+    const LatencyProfile& profile = GetLatencyProfile(mode);
+    const bool wasStarted = Device->IsStarted();
+    const ma_uint64 position = Buffer->GetGlobalFrameCount();
+
+    Device->Stop();
+    Buffer->ResetBuffer(); // Also drops a queued or spliced next track, it is prepared again later
+    DropNextTrack();
+    nextUnavailable = false;
+
+    Device->Close();
+    Buffer->ApplyLatencyProfile(profile);
+    Buffer->StartFiller(&Decoder->GetDecoder(), Decoder->GetSeekIndex(), Decoder->GetLengthInFrames(),
+                        Pather->CurrentTrackId());
+    Player->Seek(*Buffer, position);
+    Player->InitDevice(*Device, data_callback, *Buffer, profile);
+    deviceLatencyMs = Device->GetLatencyMs();
+    if (wasStarted) {
+        Device->Start();
+    }
+    RequestPrepareNext();
+
+    Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_CONTROLLER, "Latency profile: ", profile.s_name, ", device ",
+                deviceLatencyMs, " ms, ring high watermark ", profile.s_highWatermarkSeconds * 1000.0f, " ms.");
+}
+
+double PlayerController::GetDeviceLatencyMs() const {
+    return state.Load().s_deviceLatencyMs;
+}
+
+double PlayerController::GetOutputLatencyMs() const {
+    // The device is reopened on the engine thread, both parts come from what it and the callback published
+    const PlaybackSnapshot snapshot = GetPlaybackSnapshot();
+    if (snapshot.s_sampleRate == 0) {
+        return GetDeviceLatencyMs();
+    }
+    return GetDeviceLatencyMs() + snapshot.s_bufferedFrames * 1000.0 / snapshot.s_sampleRate;
+}
+
+void PlayerController::SetCrossfade(float seconds, CrossfadeCurve curve) {
+    PostCommand({CommandType::SetCrossfade, static_cast<size_t>(curve), seconds});
+}
+
+void PlayerController::SetCrossfadeNow(float seconds, CrossfadeCurve curve) {
+    crossfadeSeconds = std::max(seconds, 0.0f);
+    crossfadeCurve = curve;
+    if (Buffer) {
+        Buffer->SetCrossfade(crossfadeSeconds, crossfadeCurve);
+    }
+}
+
 void PlayerController::Play() {
-    std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::Play});
+}
+
+void PlayerController::PlayNow() {
     if (initialized && Player && Device && !isPlaying) {
-        Player->Play(*Device, *Decoder, *Timer, *Buffer);
+        Player->Play(*Device, *Buffer);
         isPlaying = true;
     }
 }
 
 void PlayerController::Pause() {
-    std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::Pause});
+}
+
+void PlayerController::PauseNow() {
     if (initialized && Player && Device) {
-        Player->Pause(*Device);
+        Player->Pause(*Buffer);
         isPlaying = false;
     }
 }
 
 void PlayerController::Stop() {
-	std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::Stop});
+}
 
+void PlayerController::StopNow() {
 	if (initialized && Player && Device) {
             {
                 // pause the play 1st
-                Player->Pause(*Device);
+                Player->Pause(*Buffer);
+                Buffer->SetPlaybackState(PlaybackState::Stopped);
                 // 设置跳转状态
-                isSeeking.store(true);
-                lastSeekTime = std::chrono::steady_clock::now();
+                isSeeking = true;
 
-                // Seek to this position
-                {
-                    if (initialized && Player && Decoder) {
-                        // 执行跳转
-                        Player->Seek(*Decoder, static_cast<ma_uint64>(0));
-                    }
-                }
-
-                // Buffer Proc
+                // Seek to the start, the filler flushes the ring so nothing stale is left
                 {
                     ma_uint64 ori_Frame = Buffer->GetGlobalFrameCount(); // For Log Using
-                    Buffer->SetGlobalFrameCount(static_cast<ma_uint64>(0));
-                    Buffer->CleaerBuffer(); // make sure there're no any data in the buffer block
+                    Player->Seek(*Buffer, static_cast<ma_uint64>(0));
                     Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_BUFFERING, "Set Read Frame form ", ori_Frame, " To ", Buffer->GetGlobalFrameCount());
                 }
             }
@@ -175,9 +476,11 @@ void PlayerController::Stop() {
 }
 
 void PlayerController::Switch(const size_t Index) {
-	std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::Switch, Index});
+}
 
-	if (!initialized || tracks.empty()) return;
+void PlayerController::SwitchNow(const size_t Index) {
+	if (!initialized || tracks->Empty()) return;
 
 
     if (Index >= Pather->TotalSong()) {
@@ -187,19 +490,21 @@ void PlayerController::Switch(const size_t Index) {
     Pather->SetIndex(Index+1);
 
 	if (isPlaying) {
-		Stop();
+		StopNow();
 	}
 	// 切换到Index
-	Player->Switch(*Pather, *Decoder, *Device, data_callback, *Timer, *Buffer,
+	Player->Switch(*Pather, *Decoder, *Device, *Timer, *Buffer,
 				  SwitchAction::PREV);
+	DropNextTrack();
+	nextUnavailable = false;
+	ScheduleReadAhead();
+	RequestPrepareNext();
 
         // 更新当前曲目索引
         currentTrack = Index;
 
         // 触发回调通知UI
-        if (trackChangeCallback) {
-            trackChangeCallback(Index);
-        }
+        NotifyTrackChangedNow(Index);
 
 	// 重置播放状态
 	isPlaying = false;
@@ -210,72 +515,74 @@ void PlayerController::Switch(const size_t Index) {
 }
 
 void PlayerController::Next() {
-    std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::Next});
+}
 
-    if (!initialized || tracks.empty()) return;
+void PlayerController::NextNow() {
+    if (!initialized || tracks->Empty()) return;
 
     // 计算下一首索引
-    size_t next = (currentTrack + 1) % tracks.size();
+    size_t next = (currentTrack + 1) % tracks->Size();
 
     // 切换到下一首
-    Player->Switch(*Pather, *Decoder, *Device, data_callback, *Timer, *Buffer,
+    Player->Switch(*Pather, *Decoder, *Device, *Timer, *Buffer,
                   SwitchAction::NEXT);
+    DropNextTrack();
+    nextUnavailable = false;
+    ScheduleReadAhead();
+    RequestPrepareNext();
 
     // 更新当前曲目
     currentTrack = next;
 
     // 通知状态改变
-    if (trackChangeCallback) {
-        trackChangeCallback(next);
-    }
+    NotifyTrackChangedNow(next);
 }
 
 void PlayerController::Prev() {
-    std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::Prev});
+}
 
-    if (!initialized || tracks.empty()) return;
+void PlayerController::PrevNow() {
+    if (!initialized || tracks->Empty()) return;
 
     // 计算上一首索引
-    size_t prev = (currentTrack == 0) ? tracks.size() - 1 : currentTrack - 1;
+    size_t prev = (currentTrack == 0) ? tracks->Size() - 1 : currentTrack - 1;
 
     // 切换到上一首
-    Player->Switch(*Pather, *Decoder, *Device, data_callback, *Timer, *Buffer,
+    Player->Switch(*Pather, *Decoder, *Device, *Timer, *Buffer,
                   SwitchAction::PREV);
+    DropNextTrack();
+    nextUnavailable = false;
+    ScheduleReadAhead();
+    RequestPrepareNext();
 
     // 更新当前曲目
     currentTrack = prev;
 
     // 通知状态改变
     // 触发回调通知UI
-    if (trackChangeCallback) {
-        trackChangeCallback(prev);
-    }
+    NotifyTrackChangedNow(prev);
 }
 
 void PlayerController::SeekToPosition(const float progress) {
-	// 设置跳转状态
-	isSeeking.store(true);
-	lastSeekTime = std::chrono::steady_clock::now();
+    PostCommand({CommandType::Seek, 0, progress});
+}
 
-    // Get the seek information
-    const auto totalFrame = Timer->GetTotalFrames();
-    const auto seekFrame = progress * static_cast<float>(totalFrame);
+void PlayerController::SeekNow(const double progress) {
+    if (!initialized || !Player || !Buffer || !Timer) return;
 
-    // Seek to this position
-    {
-        std::lock_guard<std::mutex> lock(audioMutex);
-        if (initialized && Player && Decoder) {
-            // 执行跳转
-            Player->Seek(*Decoder, static_cast<ma_uint64>(seekFrame));
-        }
-    }
+	// 设置跳转状态
+	isSeeking = true;
 
-    {
-        ma_uint64 ori_Frame = Buffer->GetGlobalFrameCount(); // For Log Using
+    // Get the seek information, in double so long files keep frame precision
+    const auto totalFrame = Timer->GetTotalFrames();
+    const auto seekFrame = static_cast<ma_uint64>(progress * static_cast<double>(totalFrame));
 
-        Buffer->SetGlobalFrameCount(static_cast<ma_uint64>(seekFrame));
-        Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_BUFFERING, "Set Read Frame form ", ori_Frame, " To ", Buffer->GetGlobalFrameCount());
-    }
+    // Queue the seek for the filler thread, it owns the decoder
+    const ma_uint64 ori_Frame = Buffer->GetGlobalFrameCount(); // For Log Using
+    Player->Seek(*Buffer, seekFrame);
+    Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_BUFFERING, "Set Read Frame form ", ori_Frame, " To ", seekFrame);
 }
 
 // void PlayerController::UpdateProgress() {
@@ -302,46 +609,73 @@ void PlayerController::SeekToPosition(const float progress) {
 // }
 
 void PlayerController::SetVolume(float vol) {
-    std::lock_guard<std::mutex> lock(audioMutex);
+    PostCommand({CommandType::SetVolume, 0, vol});
+}
 
+void PlayerController::SetVolumeNow(float vol) {
     volume = std::clamp(vol, 0.0f, 1.0f);
 
-    if (initialized && Device) {
-        ma_device_set_master_volume(&Device->GetDevice(), volume);
+    // The engine's own gain stage, ramped in the callback (the device master volume stays at unity)
+    if (initialized && Buffer) {
+        Buffer->SetGain(volume);
     }
 }
 
-const std::string& PlayerController::GetCurrentTrackName() const {
-    static const std::string empty = "No track";
-    if (tracks.empty() || currentTrack >= tracks.size()) {
-        return empty;
+PlayerController::TrackList PlayerController::GetTracks() const {
+    std::lock_guard<std::mutex> lock(tracksMutex);
+    return tracks;
+}
+
+void PlayerController::PublishTracks() {
+    // Path replaces its store on every change and never touches the old one, sharing it is enough
+    std::lock_guard<std::mutex> lock(tracksMutex);
+    tracks = Pather->GetTracks();
+}
+
+bool PlayerController::GetTrackInfo(const std::string& relativePath, TrackInfo& info) const {
+    if (!initialized || !Pather) {
+        return false;
     }
-    return tracks[currentTrack];
+    return Pather->Library().Lookup(relativePath, info);
+}
+
+std::string PlayerController::GetCurrentTrackName() const {
+    const TrackList list = GetTracks();
+    const size_t track = GetCurrentTrackIndex();
+    if (track >= list->Size()) {
+        return "No track";
+    }
+    return list->Path(track);
 }
 
 const std::string PlayerController::GetCurrentTrackProducer() const {
     static const std::string empty = "";
 
-    // 检查tracks和currentTrack的有效性
-    if (tracks.empty() || currentTrack >= tracks.size()) {
+    // 检查tracks和currentTrack的有效性 (the published list and index, Pather belongs to the engine thread)
+    const TrackList list = GetTracks();
+    const size_t track = GetCurrentTrackIndex();
+    if (track >= list->Size()) {
         return empty;
     }
 
     // 获取当前文件路径
-    const std::string& filePath = Pather->CurrentFilePath();
-    if (filePath.empty()) {
-        return empty;
+    const std::string filePath = (Pather->Root() / list->Path(track)).string();
+
+    // The library index first: read once, kept across launches
+    TrackInfo info;
+    if (Pather->Library().Lookup(list->Path(track), info)) {
+        return info.s_artist;
     }
 
     // 获取音频元数据读取器实例
     auto& reader = AudioMetadataReader::getInstance();
 
-    bool isPureAscii = Encoder->IsPureAscii(Pather->CurrentFilePath());
+    bool isPureAscii = Encoder->IsPureAscii(filePath);
     if  (isPureAscii == false) {
         // 直接返回结果，确保getSongProducer()返回有效引用
-        return reader.getSongProducer(Encoder->u8tou16(Pather->CurrentFilePath()));
+        return reader.getSongProducer(Encoder->u8tou16(filePath));
     } else{
-        return reader.getSongProducer(Pather->CurrentFilePath());
+        return reader.getSongProducer(filePath);
     }
 }
 
@@ -349,15 +683,23 @@ const std::vector<unsigned char> PlayerController::GetCurrentTrackAlbum() {
     // 返回空向量表示无数据
     static const std::vector<unsigned char> empty;
 
-    // 检查tracks和currentTrack的有效性
-    if (tracks.empty() || currentTrack >= tracks.size()) {
+    // 检查tracks和currentTrack的有效性 (the published list and index, Pather belongs to the engine thread)
+    const TrackList list = GetTracks();
+    const size_t track = GetCurrentTrackIndex();
+    if (track >= list->Size()) {
         return empty;
     }
 
     // 获取当前文件路径
-    const std::string& filePath = Pather->CurrentFilePath();
-    if (filePath.empty()) {
-        return empty;
+    const std::string filePath = (Pather->Root() / list->Path(track)).string();
+
+    // The index knows where the picture sits in the file, read just those bytes
+    TrackInfo info;
+    if (Pather->Library().Lookup(list->Path(track), info) && info.s_coverSize > 0) {
+        std::vector<unsigned char> cover = LibraryIndex::ReadCover(fs::path(filePath), info);
+        if (!cover.empty()) {
+            return cover;
+        }
     }
 
     // 获取音频元数据读取器实例
@@ -377,42 +719,112 @@ const std::vector<unsigned char> PlayerController::GetCurrentTrackAlbum() {
     }
 }
 
-void PlayerController::NotifyTrackChanged() {
-    if (trackChangeCallback) {
-        trackChangeCallback(currentTrack);
+void PlayerController::OnLibraryChanged(LibraryChanges changes) {
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        pendingLibraryChanges.push_back(std::move(changes));
     }
+    // Dropped when the queue is full, the changes wait for the next batch then
+    PostCommand({CommandType::ApplyLibraryChanges});
 }
 
+void PlayerController::ApplyLibraryChangesNow() {
+    std::vector<LibraryChanges> batches;
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex);
+        batches.swap(pendingLibraryChanges);
+    }
+    if (!initialized || !Pather) return;
+
+    // The prepared track is found again by its id, its index moves with the list
+    const TrackId prepared = NextDecoder && preparedTrack < tracks->Size() ? tracks->Id(preparedTrack) : TrackStore::NoTrack;
+    bool changed = false;
+    for (const auto& changes : batches) {
+        changed = Pather->ApplyChanges(changes) || changed;
+    }
+    if (!changed) return;
+
+    // Pather keeps the current track, the one playing is not touched
+    PublishTracks();
+    currentTrack = Pather->Index();
+    if (NextDecoder) {
+        const size_t next = tracks->Empty() ? 0 : (currentTrack + 1) % tracks->Size();
+        const size_t index = tracks->IndexOf(prepared);
+        if (index != next && Buffer->CancelNext()) {
+            DropNextTrack(); // Not spliced yet, prepare what follows now instead
+        } else {
+            preparedTrack = index < tracks->Size() ? index : next; // Spliced, it plays out as prepared
+        }
+    }
+    nextUnavailable = false;
+    RequestPrepareNext();
+    ScheduleReadAhead();
 
+    Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_CONTROLLER, "Library updated: ", tracks->Size(), " tracks, current ", currentTrack);
+    NotifyLibraryChangedNow();
+}
 
+void PlayerController::NotifyLibraryChangedNow() {
+    LibraryChangeCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        callback = libraryChangeCallback;
+    }
+    if (callback) {
+        callback();
+    }
+}
 
-float PlayerController::GetCurrentProgress() const {
-    if (!initialized || !Timer || Timer->GetTotalFrames() == 0)
-        return 0.0f;
+void PlayerController::NotifyTrackChanged() {
+    NotifyTrackChangedNow(GetCurrentTrackIndex());
+}
 
-    return static_cast<float>(GetCurrentFrame()) /
-           static_cast<float>(GetTotalFrames());
+void PlayerController::NotifyTrackChangedNow(size_t index) {
+    // Call a copy outside the lock, so the UI can replace the callback from inside it
+    TrackChangeCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        callback = trackChangeCallback;
+    }
+    if (callback) {
+        callback(index);
+    }
 }
 
-float PlayerController::GetCurrentTime() const {
-    if (!initialized || !Timer)
-        return 0.0f;
 
 
-    return static_cast<float>(GetCurrentFrame() / Decoder->GetDecoder().outputSampleRate);
+
+PlaybackSnapshot PlayerController::GetPlaybackSnapshot() const {
+    if (!initialized || !Buffer) {
+        return {};
+    }
+    return Buffer->GetSnapshot();
 }
 
-float PlayerController::GetTotalTime() const {
-    if (!initialized || !Timer || !Timer->GetTotalFrames())
-        return 0.0f;
+double PlayerController::GetHeardFrame(const PlaybackSnapshot& snapshot) const {
+    return playhead.HeardFrame(snapshot, AudioBuffering::NowNs());
+}
+
+double PlayerController::GetCurrentProgress() const {
+    const PlaybackSnapshot snapshot = GetPlaybackSnapshot();
+    if (snapshot.s_totalFrames == 0)
+        return 0.0;
 
-    return static_cast<float>(GetTotalFrames()) / Decoder->GetDecoder().outputSampleRate;
+    return GetHeardFrame(snapshot) / static_cast<double>(snapshot.s_totalFrames);
 }
 
-ma_uint64 PlayerController::GetCurrentFrame() const {
-    return Buffer ? static_cast<float>(Buffer->GetGlobalFrameCount()) : 0;
+double PlayerController::GetCurrentTime() const {
+    const PlaybackSnapshot snapshot = GetPlaybackSnapshot();
+    if (snapshot.s_sampleRate == 0)
+        return 0.0;
+
+    return GetHeardFrame(snapshot) / snapshot.s_sampleRate;
 }
 
-ma_uint64 PlayerController::GetTotalFrames() const {
-    return Buffer ? static_cast<float>(Timer->GetTotalFrames()) : 0;
+double PlayerController::GetTotalTime() const {
+    const PlaybackSnapshot snapshot = GetPlaybackSnapshot();
+    if (snapshot.s_sampleRate == 0)
+        return 0.0;
+
+    return static_cast<double>(snapshot.s_totalFrames) / snapshot.s_sampleRate;
 }
@@ -20,20 +20,49 @@
 
 // Basic Lib
 #include "../Engine/Buffering.hpp"
+#include "../Engine/DecodeService.hpp"
 #include "../Engine/Decoder.hpp"
 #include "../Engine/Device.hpp"
+#include "../Engine/EventQueue.hpp"
+#include "../Engine/OutputSink.hpp"
 #include "../Engine/Player.hpp"
+#include "../Engine/Seqlock.hpp"
 #include "../Engine/Status.hpp"
 #include "../FileSystem/Path.hpp"
+#include "../FileSystem/LibraryWatcher.hpp"
 #include "../FileSystem/Metadata.hpp"
 #include "../FileSystem/Encoding.hpp"
 
+// Controller state as the engine thread last published it, read by any thread in one consistent copy
+struct ControllerState {
+    size_t s_track = 0;                 // 当前曲目索引
+    bool s_playing = false;
+    bool s_gapless = true;
+    float s_volume = 0.8f;
+    float s_crossfadeSeconds = 0.0f;
+    LatencyMode s_latencyMode = LatencyMode::Balanced;
+    double s_deviceLatencyMs = 0.0;     // 设备实际分配的缓冲, as of the last InitDevice()
+};
+
+// Threading: the public control calls only queue a command and return. One engine thread owns the
+// decoder, device and buffer: it runs the commands in order, handles the engine events, and
+// publishes ControllerState after each one. Initialize() and Cleanup() run while it is not running;
+// commands posted before Initialize() run at its start, those posted during it once the engine thread is up.
 class PlayerController {
 public:
+    static constexpr size_t ReadAheadTracks = 2; // 预读的后续曲目数
+    static constexpr size_t CommandCapacity = 64; // 待执行命令的上限, 满了之后新命令被丢弃
+
     // 回调类型定义
     using TrackChangeCallback = std::function<void(size_t newIndex)>;
+    using ScanBatchCallback = LibraryScanner::BatchCallback;
+    using LibraryChangeCallback = std::function<void()>;
+
+    // The track list as published by the engine thread, a snapshot that stays valid while it is held
+    using TrackList = std::shared_ptr<const TrackStore>;
     
-    PlayerController();
+    // sink: where the audio goes, nullptr for the sound card. Not owned, must outlive the controller.
+    explicit PlayerController(OutputSink* sink = nullptr);
     ~PlayerController();
     
     // 禁止拷贝和赋值
@@ -46,7 +75,7 @@ public:
     // 清理资源
     void Cleanup();
     
-    // 播放控制
+    // 播放控制 (non-blocking, executed in order on the engine thread)
     void Play();
     void Pause();
     void Stop();
@@ -56,73 +85,173 @@ public:
     void SeekToPosition(const float Progress);
     void SetVolume(float vol);
 
-    // Progress
-    float GetCurrentProgress() const;
-    float GetCurrentTime() const; // 当前播放时间(秒)
-    float GetTotalTime() const;   // 总时长(秒)
+    // 无缝播放 (预先打开并解码下一首, 拼接进同一个环形缓冲区)
+    void SetGapless(bool enabled);
+    bool IsGapless() const { return state.Load().s_gapless; }
+
+    // 交叉淡入淡出 (需要无缝播放): 当前曲目的最后 seconds 秒与下一首的开头混合, 0 为关闭
+    void SetCrossfade(float seconds, CrossfadeCurve curve = CrossfadeCurve::EqualPower);
+    float GetCrossfadeSeconds() const { return state.Load().s_crossfadeSeconds; }
 
-    // 状态获取
-    float GetVolume() const { return volume; }
+    // 延迟档位: 设备周期/周期数与环形缓冲区容量/水位一起切换
+    void SetLatencyProfile(LatencyMode mode);
+    LatencyMode GetLatencyMode() const { return state.Load().s_latencyMode; }
+    double GetDeviceLatencyMs() const; // 设备实际分配的硬件缓冲
+    double GetOutputLatencyMs() const; // 端到端: 硬件缓冲 + 环形缓冲区中已解码待播放的部分
 
-    bool IsPlaying() const { return isPlaying.load(); }
+    // Progress: one wait-free read of what the audio callback last published (position, length,
+    // rate, state and track together). The helpers below each take their own snapshot, time and
+    // progress follow the playhead clock (what is audible now, see AudioBuffering::HeardFrame()).
+    // GetHeardFrame() reads a snapshot through the same clock, it never steps back between two calls.
+    PlaybackSnapshot GetPlaybackSnapshot() const;
+    double GetHeardFrame(const PlaybackSnapshot& snapshot) const;
+    double GetCurrentProgress() const;
+    double GetCurrentTime() const; // 当前播放时间(秒), 已扣除设备延迟并在回调之间插值
+    double GetTotalTime() const;   // 总时长(秒)
+
+    // 状态获取 (the last published state, wait for the engine thread to catch up after a command)
+    ControllerState GetState() const { return state.Load(); }
+    float GetVolume() const { return state.Load().s_volume; }
+
+    bool IsPlaying() const { return state.Load().s_playing; }
     bool IsInitialized() const { return initialized; }
-    size_t GetCurrentTrackIndex() const { return currentTrack.load(); }
-    const std::string& GetCurrentTrackName() const;
+    size_t GetCurrentTrackIndex() const { return state.Load().s_track; }
+    std::string GetCurrentTrackName() const;
     const std::string GetCurrentTrackProducer() const;
     const std::vector<unsigned char> GetCurrentTrackAlbum();
-    const std::vector<std::string>& GetTracks() const { return tracks; }
+    TrackList GetTracks() const;
+    // Tags of any track by its relative path (TrackStore::Path()), from the library index. Any thread.
+    bool GetTrackInfo(const std::string& relativePath, TrackInfo& info) const;
 
-    // 回调设置
+    // 回调设置 (called on the engine thread)
     void SetTrackChangeCallback(TrackChangeCallback callback) {
-        trackChangeCallback = callback;
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        trackChangeCallback = std::move(callback);
     }
     
+    // Set before Initialize(): sees the library while it is scanned, in batches, from the scanner threads
+    void SetScanBatchCallback(ScanBatchCallback callback) { scanBatchCallback = std::move(callback); }
+
+    // The library folder changed while playing and GetTracks() has the new list (called on the engine thread).
+    // The current track stays the current one, its index may have moved.
+    void SetLibraryChangeCallback(LibraryChangeCallback callback) {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        libraryChangeCallback = std::move(callback);
+    }
+
     // 内部使用的回调（由AudioPlayer调用）
     void NotifyTrackChanged();
 
 private:
+    enum class CommandType : ma_uint8 {
+        Play, Pause, Stop, Next, Prev, Switch, Seek, SetVolume, SetGapless, SetCrossfade, SetLatencyProfile,
+        ApplyLibraryChanges,
+    };
+
+    struct Command {
+        CommandType s_type = CommandType::Play;
+        size_t s_index = 0;    // Switch: track index, SetGapless: 0/1, enums as their value
+        double s_value = 0.0;  // Seek: progress, SetVolume / SetCrossfade: the value
+    };
+
+    // Lifecycle of the engine thread, decides what PostCommand() does with a command
+    enum class EngineStage : ma_uint8 {
+        Idle,     // no engine thread (before Initialize(), after Cleanup()): queue it, Initialize() runs it first
+        Starting, // Initialize() is building the engine: queue it for the engine thread
+        Running,  // queue it and wake the engine thread
+        Stopping, // Cleanup() is tearing down: drop it
+    };
+
+    // Queue a command and wake the engine thread, see EngineStage. Dropped when the queue is full.
+    // Lock-free: only Initialize() / Cleanup() change the stage, and each drains the queue after it does.
+    void PostCommand(const Command& command);
+    void ExecuteCommand(const Command& command);
+    void PublishState();
+
+    // Command bodies, engine thread only
+    void PlayNow();
+    void PauseNow();
+    void StopNow();
+    void SwitchNow(size_t Index);
+    void NextNow();
+    void PrevNow();
+    void SeekNow(double progress);
+    void SetVolumeNow(float vol);
+    void SetGaplessNow(bool enabled);
+    void SetCrossfadeNow(float seconds, CrossfadeCurve curve);
+    void SetLatencyProfileNow(LatencyMode mode);
+    void ApplyLibraryChangesNow();
+    void NotifyTrackChangedNow(size_t index);
+    void NotifyLibraryChangedNow();
+
+    // Library watcher thread: queue the changes for the engine thread
+    void OnLibraryChanged(LibraryChanges changes);
+    void PublishTracks(); // Pather's list -> tracks
+
     // 内部初始化方法
     bool InitializeAudioComponents();
+    bool AbortInitialize(); // Initialize() failed: run the commands queued meanwhile, back to Idle
     
-    // 线程函数
-    void NextFileCheckThread();
+    // 引擎线程: 执行命令并处理引擎事件 (曲目结束, 越过拼接点, 跳转完成), 没有轮询
+    void EngineThread();
+    void HandleEngineEvent(const EngineEvent& event);
+
+    // Gapless helpers, engine thread only
+    void PrepareNextTrack();
+    void AdvanceToPreparedTrack();
+    void DropNextTrack();
+    void ScheduleReadAhead();
+    void RequestPrepareNext(); // the event thread opens the next track, so switches stay quick
     
     // 成员变量
-    std::vector<std::string> tracks; // tacks name
-    std::atomic<size_t> currentTrack{0};
-    std::atomic<bool> isPlaying{false};
-    std::atomic<bool> AutoSwitch{false};
-    std::atomic<bool> isSeeking{false};
-    std::chrono::steady_clock::time_point lastSeekTime;
+    // Owned by the engine thread (or by Initialize() before it starts), others read `state`
+    TrackList tracks = std::make_shared<const TrackStore>(); // tacks name, replaced (under tracksMutex) when the library changes
+    size_t currentTrack = 0;
+    size_t preparedTrack = 0; // 预先打开的下一首的索引
+    bool isPlaying = false;
+    bool isSeeking = false;
+    bool gapless = true;
+    LatencyMode latencyMode = LatencyMode::Balanced;
+    double deviceLatencyMs = 0.0; // What the backend granted, read back after each InitDevice()
+    float crossfadeSeconds = 0.0f;
+    CrossfadeCurve crossfadeCurve = CrossfadeCurve::EqualPower;
+    bool nextUnavailable = false; // the next file failed to open, don't retry until the track changes
     float volume = 0.8f;
     
     // 全局对象（使用智能指针管理）
     std::unique_ptr<Path> Pather;
+    std::unique_ptr<LibraryWatcher> Watcher;
     std::unique_ptr<Encoding> Encoder;
     std::unique_ptr<AudioDecoder> Decoder;
-    AudioDevice* Device = nullptr;
+    std::unique_ptr<AudioDecoder> NextDecoder; // 无缝播放时预先打开的下一首
+    OutputSink* Device = nullptr; // 输出: 声卡单例, 或调用方给的离线输出
     std::unique_ptr<AudioPlayer> Player;
     std::unique_ptr<Status> Timer;
     std::unique_ptr<AudioBuffering> Buffer;
     std::unique_ptr<AudioMetadataReader> Metadata;
+    std::vector<std::pair<std::string, DecodeService::Job>> readAheadJobs; // 预读任务 (路径, 任务)
     
     // 线程控制
-    std::atomic<bool> running{true};
-    std::thread nextCheckThread;
-    std::thread playThread;
+    std::atomic<bool> running{false}; // true while the engine thread runs
+    std::atomic<EngineStage> stage{EngineStage::Idle};
+    std::atomic<ma_uint32> posting{0}; // PostCommand() calls in flight, Cleanup() waits them out before tearing down
+    std::thread engineThread;
+    EventQueue<Command, CommandCapacity> commands; // MPSC: any thread -> engine thread
+    Seqlock<ControllerState> state;                // engine thread -> any thread
+    mutable PlayheadClock playhead;                // Shared by every reader of the position
     
     // 状态标志
-    bool initialized = false;
+    std::atomic<bool> initialized{false}; // Initialize() may run on a worker thread, the UI polls this meanwhile
     
     // 回调函数
     TrackChangeCallback trackChangeCallback; // 新增回调
-    
-    // 互斥锁
-    mutable std::mutex audioMutex;
+    LibraryChangeCallback libraryChangeCallback;
+    ScanBatchCallback scanBatchCallback;     // Only used inside Initialize()
+    std::mutex callbackMutex; // only guards the callbacks above, never held while the engine works
 
-    // Progress
-    ma_uint64 GetCurrentFrame() const;
-    ma_uint64 GetTotalFrames() const;
+    mutable std::mutex tracksMutex;                   // guards replacing `tracks`
+    std::vector<LibraryChanges> pendingLibraryChanges; // watcher -> engine thread, under libraryMutex
+    std::mutex libraryMutex;
 };
 
 #endif // MUSICPLAYERSTATE_HPP
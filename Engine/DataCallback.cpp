@@ -14,41 +14,42 @@
 // Basic Lib
 #include "../miniaudio/miniaudio.h"
 #include "Buffering.hpp"
-#include "Controller.hpp"
 
+// All state comes from the per-stream StreamContext in pUserData: no statics, no divisions,
+// and the only branches besides the copy are the seek flush check, the pause hold, the gain stage,
+// the refill request and the snapshot for the UI.
 void data_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount) {
-	auto* buffering = static_cast<AudioBuffering*>(pDevice->pUserData);
-	static ma_uint64 consumedFrames = 0;
+	const auto* context = static_cast<const StreamContext*>(pDevice->pUserData);
+	AudioBuffering* buffering = context->s_owner;
 
-	const int currentBufIdx = buffering->GetActiveBuffer();
-	AudioBuffering::Buffer& currentBuf = buffering->GetBuffers()[currentBufIdx];
+	// Drop frames made stale by a seek before reading anything (also while paused, so the position follows)
+	buffering->ApplyFlush();
 
-	if (!currentBuf.s_ready) {
-		memset(pOutput, 0, frameCount * ma_get_bytes_per_frame(pDevice->playback.format, pDevice->playback.channels));
+	// Paused and faded out: keep the device running on silence, the ring keeps its place
+	if (buffering->HoldOutput()) {
+		memset(pOutput, 0, static_cast<size_t>(frameCount) * context->s_bytesPerFrame);
+		buffering->PublishSnapshot();
 		return;
 	}
 
-	const ma_uint64 availableFrames = currentBuf.s_totalFrames - consumedFrames;
-	const ma_uint64 framesToCopy = std::min(static_cast<ma_uint64>(frameCount), availableFrames);
+	// Drain whatever the filler has published, any number of frames
+	const ma_uint64 framesCopied = context->s_ring->Read(pOutput, frameCount);
+	buffering->ConsumeFrames(framesCopied);
 
-	const size_t bytesToCopy = framesToCopy * ma_get_bytes_per_frame(pDevice->playback.format, pDevice->playback.channels);
-	memcpy(
-		pOutput,
-		currentBuf.s_data.data() + consumedFrames * ma_get_bytes_per_frame(pDevice->playback.format, pDevice->playback.channels),
-		bytesToCopy
-	);
+	// Volume, pause fades and clipping protection in place on the decoded frames (the padding below is silent anyway)
+	if (context->s_floatSamples) {
+		buffering->ApplyGain(static_cast<float*>(pOutput), framesCopied);
+	}
 
-	consumedFrames += framesToCopy;
-	buffering->ConsumeFrames(framesToCopy);
+	// Underrun (or end of file): pad the rest of the period with silence, a zero-byte memset otherwise
+	const ma_uint32 bytesPerFrame = context->s_bytesPerFrame;
+	memset(static_cast<char*>(pOutput) + framesCopied * bytesPerFrame, 0, (frameCount - framesCopied) * bytesPerFrame);
 
-	if (consumedFrames >= currentBuf.s_totalFrames) {
-		currentBuf.s_ready = false;
-		buffering->SwitchBuffer();
-		consumedFrames = 0;
+	// Wake the filler once we cross the low watermark, it sleeps otherwise
+	if (context->s_ring->AvailableRead() <= buffering->GetLowWatermark()) {
+		buffering->RequestRefill();
 	}
 
-	if (framesToCopy < frameCount) {
-		const size_t remainingBytes = (frameCount - framesToCopy) * ma_get_bytes_per_frame(pDevice->playback.format, pDevice->playback.channels);
-		memset(static_cast<char*>(pOutput) + bytesToCopy, 0, remainingBytes);
-	}
+	// One consistent position / length / track for the UI
+	buffering->PublishSnapshot();
 }
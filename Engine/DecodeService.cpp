@@ -0,0 +1,143 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: DecodeService.cpp
+ *  Lib: Beeplayer Core engine Decode Thread Pool
+ *  Author: Romi Brooks
+ *  Date: 2025-07-24
+ *  Type: Decoder, Threading, Core Engine
+ */
+
+#include "DecodeService.hpp"
+
+// Standard Lib
+#include <algorithm>
+
+// Basic Lib
+#include "../Log/LogSystem.hpp"
+
+bool DecodeService::Job::IsDone() const {
+	if (!p_state) return true;
+	std::lock_guard<std::mutex> lock(p_state->s_mutex);
+	return p_state->s_done;
+}
+
+void DecodeService::Job::Cancel() {
+	if (p_state) {
+		p_state->s_cancelled.store(true, std::memory_order_release);
+	}
+}
+
+void DecodeService::Job::Wait() {
+	if (!p_state) return;
+	std::unique_lock<std::mutex> lock(p_state->s_mutex);
+	p_state->s_doneSignal.wait(lock, [this]() { return p_state->s_done; });
+}
+
+DecodeService::DecodeService() {
+	const unsigned hardware = std::thread::hardware_concurrency();
+	const unsigned count = std::clamp(hardware > 1 ? hardware - 1 : MinWorkers, MinWorkers, MaxWorkers);
+
+	p_workers.reserve(count);
+	for (unsigned i = 0; i < count; ++i) {
+		p_workers.emplace_back(&DecodeService::Worker, this, i == 0);
+	}
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DECODER, "Decode service started with ", count, " workers.");
+}
+
+DecodeService::~DecodeService() {
+	Shutdown();
+}
+
+DecodeService::Job DecodeService::Submit(DecodePriority Priority, Work Task) {
+	auto state = std::make_shared<JobState>();
+	state->s_work = std::move(Task);
+
+	bool queued = false;
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+		if (!p_stopping) {
+			p_queues[static_cast<size_t>(Priority)].push_back(state);
+			queued = true;
+		}
+	}
+
+	if (!queued) {
+		// Shut down already, the job will never run
+		Finish(state);
+	} else {
+		// Wake everyone: notify_one could pick the reserved worker for a job it may not take
+		p_workSignal.notify_all();
+	}
+	return Job(std::move(state));
+}
+
+void DecodeService::Shutdown() {
+	std::vector<std::shared_ptr<JobState>> dropped;
+	{
+		std::lock_guard<std::mutex> lock(p_mutex);
+		if (p_stopping) return;
+		p_stopping = true;
+
+		for (auto& queue : p_queues) {
+			dropped.insert(dropped.end(), queue.begin(), queue.end());
+			queue.clear();
+		}
+	}
+	p_workSignal.notify_all();
+
+	for (const auto& state : dropped) {
+		Finish(state);
+	}
+	for (auto& worker : p_workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	p_workers.clear();
+}
+
+size_t DecodeService::GetPendingCount(DecodePriority Priority) const {
+	std::lock_guard<std::mutex> lock(p_mutex);
+	return p_queues[static_cast<size_t>(Priority)].size();
+}
+
+std::shared_ptr<DecodeService::JobState> DecodeService::TakeJob(bool StreamOnly) {
+	const size_t lowest = StreamOnly ? 1 : PriorityCount;
+	for (size_t priority = 0; priority < lowest; ++priority) {
+		auto& queue = p_queues[priority];
+		if (!queue.empty()) {
+			auto state = std::move(queue.front());
+			queue.pop_front();
+			return state;
+		}
+	}
+	return nullptr;
+}
+
+void DecodeService::Worker(bool StreamOnly) {
+	for (;;) {
+		std::shared_ptr<JobState> state;
+		{
+			std::unique_lock<std::mutex> lock(p_mutex);
+			p_workSignal.wait(lock, [&]() { return p_stopping || (state = TakeJob(StreamOnly)) != nullptr; });
+			if (!state) return; // Stopping and nothing left for us
+		}
+
+		if (!state->s_cancelled.load(std::memory_order_acquire)) {
+			try {
+				state->s_work(state->s_cancelled);
+			} catch (const std::exception& e) {
+				Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_DECODER, "Decode job failed: ", e.what());
+			}
+		}
+		Finish(state);
+	}
+}
+
+void DecodeService::Finish(const std::shared_ptr<JobState>& State) {
+	State->s_work = nullptr; // Release whatever the job captured before anyone waits on it
+	{
+		std::lock_guard<std::mutex> lock(State->s_mutex);
+		State->s_done = true;
+	}
+	State->s_doneSignal.notify_all();
+}
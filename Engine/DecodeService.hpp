@@ -0,0 +1,102 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: DecodeService.hpp
+ *  Lib: Beeplayer Core engine Decode Thread Pool definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-07-24
+ *  Type: Decoder, Threading, Core Engine
+ */
+
+#ifndef DECODESERVICE_HPP
+#define DECODESERVICE_HPP
+
+// Standard Lib
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// All decoder work runs on one fixed pool: the stream that is playing, read-ahead of upcoming
+// playlist entries and background analysis (seek indexes). Jobs are taken strictly by priority,
+// and worker 0 only ever runs Stream jobs, so a pool busy with read-ahead can never keep the
+// playing stream from getting a thread.
+
+enum class DecodePriority {
+	Stream = 0,     // The filler of the stream being heard
+	ReadAhead = 1,  // Warming up the next playlist entries
+	Background = 2, // Analysis nobody is waiting for
+};
+
+class DecodeService {
+	private:
+		struct JobState {
+			std::function<void(const std::atomic<bool>&)> s_work;
+			std::atomic<bool> s_cancelled{false};
+			std::mutex s_mutex;
+			std::condition_variable s_doneSignal;
+			bool s_done = false;      // Guarded by s_mutex
+		};
+
+	public:
+		// Owner's view of a submitted job. Dropping the handle does not cancel the job.
+		class Job {
+			public:
+				Job() = default;
+
+				bool Valid() const { return p_state != nullptr; }
+				bool IsDone() const;
+
+				// A pending job is dropped, a running one sees the flag passed to its work function
+				void Cancel();
+				void Wait();
+				void CancelAndWait() { Cancel(); Wait(); }
+
+			private:
+				friend class DecodeService;
+				explicit Job(std::shared_ptr<JobState> State) : p_state(std::move(State)) {}
+				std::shared_ptr<JobState> p_state;
+		};
+
+		using Work = std::function<void(const std::atomic<bool>& Cancelled)>;
+
+		static constexpr unsigned MinWorkers = 2; // One reserved for Stream, at least one for the rest
+		static constexpr unsigned MaxWorkers = 4;
+
+		// Singleton Instance
+		static DecodeService& GetInstance() {
+			static DecodeService service;
+			return service;
+		}
+
+		DecodeService(const DecodeService&) = delete;
+		void operator=(const DecodeService&) = delete;
+
+		Job Submit(DecodePriority Priority, Work Task);
+
+		// Cancels everything pending and joins the workers, Submit() afterwards runs nothing
+		void Shutdown();
+
+		unsigned GetWorkerCount() const { return static_cast<unsigned>(p_workers.size()); }
+		size_t GetPendingCount(DecodePriority Priority) const;
+
+	private:
+		static constexpr size_t PriorityCount = 3;
+
+		std::vector<std::thread> p_workers;
+		std::deque<std::shared_ptr<JobState>> p_queues[PriorityCount]; // Indexed by DecodePriority
+		mutable std::mutex p_mutex;
+		std::condition_variable p_workSignal;
+		bool p_stopping = false;
+
+		DecodeService();
+		~DecodeService();
+
+		void Worker(bool StreamOnly);
+		std::shared_ptr<JobState> TakeJob(bool StreamOnly); // p_mutex held
+		void Finish(const std::shared_ptr<JobState>& State);
+};
+
+#endif //DECODESERVICE_HPP
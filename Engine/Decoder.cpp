@@ -9,6 +9,11 @@
 #include "Decoder.hpp"
 
 // Standard Lib
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <vector>
 
 // Basic Lib
 #include "../FileSystem/Encoding.hpp"
@@ -18,22 +23,71 @@ ma_decoder & AudioDecoder::GetDecoder() {
     return this->p_decoder;
 }
 
-void AudioDecoder::InitDecoder(const std::string &FilePath) {
-	ma_result result;
+static ma_result InitFile(const std::string &FilePath, const ma_decoder_config* Config, ma_decoder* pDecoder) {
 #ifdef _WIN32
 	if (Encoding::IsPureAscii(FilePath)) {
-		result = ma_decoder_init_file(FilePath.c_str(), nullptr, &this->p_decoder);
-	} else {
-		std::wstring widePath = Encoding::u8tou16(FilePath);
-		result = ma_decoder_init_file_w(widePath.c_str(), nullptr, &this->p_decoder);
+		return ma_decoder_init_file(FilePath.c_str(), Config, pDecoder);
 	}
+	std::wstring widePath = Encoding::u8tou16(FilePath);
+	return ma_decoder_init_file_w(widePath.c_str(), Config, pDecoder);
 #else
-	result = ma_decoder_init_file(FilePath.c_str(), nullptr, &this->p_decoder);
+	return ma_decoder_init_file(FilePath.c_str(), Config, pDecoder);
 #endif
-	
+}
+
+static bool IsMp3(const std::string &FilePath) {
+	std::string extension = std::filesystem::path(FilePath).extension().string();
+	std::ranges::transform(extension, extension.begin(), [](unsigned char c) { return std::tolower(c); });
+	return extension == ".mp3";
+}
+
+bool AudioDecoder::InitDecoder(const std::string &FilePath, const ma_decoder_config* Config) {
+	p_seekIndex.reset();
+
+	ma_result result = MA_ERROR;
+	if (IsMp3(FilePath)) {
+		// Pin the MP3 backend so the seek index can be bound to it
+		ma_decoder_config mp3Config = Config ? *Config : ma_decoder_config_init_default();
+		mp3Config.encodingFormat = ma_encoding_format_mp3;
+		result = InitFile(FilePath, &mp3Config, &this->p_decoder);
+		if (result == MA_SUCCESS) {
+			p_seekIndex = SeekIndex::ForFile(FilePath); // The read-ahead's, if it is still being built
+			SeekIndex::BuildAsync(p_seekIndex);
+		}
+	}
+	if (result != MA_SUCCESS) {
+		result = InitFile(FilePath, Config, &this->p_decoder);
+	}
+
 	if (result != MA_SUCCESS) {
 		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_DECODER, "Error loading file: " , FilePath);
-		return;
+		return false;
 	}
+	// Can mean a full scan (MP3), so it is done once here and shared by the timer and the crossfade
+	p_lengthFrames = 0;
+	ma_decoder_get_length_in_pcm_frames(&this->p_decoder, &p_lengthFrames);
+
 	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DECODER, "Init completed with Sample rate: ", p_decoder.outputSampleRate, "Hz, Format: ", p_decoder.outputFormat);
-}
\ No newline at end of file
+	return true;
+}
+
+DecodeService::Job AudioDecoder::ReadAhead(const std::string &FilePath) {
+	return DecodeService::GetInstance().Submit(DecodePriority::ReadAhead, [FilePath](const std::atomic<bool>& Cancelled) {
+#ifdef _WIN32
+		std::ifstream in(std::filesystem::path(Encoding::u8tou16(FilePath)), std::ios::binary);
+#else
+		std::ifstream in(FilePath, std::ios::binary);
+#endif
+		std::vector<char> block(256 * 1024);
+		size_t total = 0;
+		while (total < ReadAheadBytes && !Cancelled.load(std::memory_order_relaxed)
+			   && in.read(block.data(), static_cast<std::streamsize>(block.size()))) {
+			total += block.size();
+		}
+
+		// The table lands in the disk cache, the decoder that opens this file later just loads it
+		if (!Cancelled.load(std::memory_order_relaxed) && IsMp3(FilePath)) {
+			SeekIndex::BuildAsync(SeekIndex::ForFile(FilePath));
+		}
+	});
+}
@@ -10,19 +10,36 @@
 #define DECODER_HPP
 
 // Standard Lib
+#include <memory>
 #include <string>
 
 // Basic Lib
 #include "../miniaudio/miniaudio.h"
+#include "DecodeService.hpp"
+#include "SeekIndex.hpp"
 
 class AudioDecoder {
     public:
         AudioDecoder() : p_decoder{} {}
         ma_decoder& GetDecoder();
 
-        void InitDecoder(const std::string& FilePath);
+        // Config may ask miniaudio to convert to a given format/channels/rate (nullptr keeps the file's native one)
+        bool InitDecoder(const std::string& FilePath, const ma_decoder_config* Config = nullptr);
+
+        // Total frames in the output rate, read once at init (0 if the format can't tell)
+        ma_uint64 GetLengthInFrames() const { return p_lengthFrames; }
+
+        // MP3 files get a seek index built in the background, nullptr for everything else
+        SeekIndex* GetSeekIndex() const { return p_seekIndex.get(); }
+
+        // Read-ahead for an upcoming playlist entry: pulls the head of the file into the OS cache
+        // and queues its seek index, so opening it later is cheap. Cancel the job if the entry goes stale.
+        static constexpr size_t ReadAheadBytes = 8 * 1024 * 1024;
+        static DecodeService::Job ReadAhead(const std::string& FilePath);
 
     private:
         ma_decoder p_decoder;
+        ma_uint64 p_lengthFrames = 0;
+        std::shared_ptr<SeekIndex> p_seekIndex;
 };
 #endif //DECODER_HPP
@@ -8,6 +8,9 @@
 
 #include "Device.hpp"
 
+// Standard Lib
+#include <chrono>
+
 // Basic Lib
 #include "../Log/LogSystem.hpp"
 
@@ -15,28 +18,79 @@ ma_device & AudioDevice::GetDevice() {
 	return this->p_device;
 }
 
-void AudioDevice::InitDeviceConfig(const ma_uint32 &SampleRate, const ma_format &Format, const ma_device_data_proc &Callback, ma_decoder &Decoder, void* DoubleBuffering) {
+ma_decoder_config AudioDevice::DecoderConfig() {
+	return ma_decoder_config_init(OutputFormat, OutputChannels, OutputSampleRate);
+}
+
+void AudioDevice::InitDeviceConfig(const ma_device_data_proc &Callback, void* UserData, const LatencyProfile& Profile) {
 	p_deviceConfig = ma_device_config_init(ma_device_type_playback);
-    p_deviceConfig.playback.format   = Format;
+    p_deviceConfig.playback.format   = OutputFormat;
     // Device channels equal 2, indicating stereo.
     // Actually, No one can use this pieces of shit exec to listen 7.1 or something right?
-    p_deviceConfig.playback.channels = 2;
-    // Under normal conditions, the sample rate is 44.1 kHz or 48.0 kHz.
-    // When tracks are switched, the sample rate may change.
-    // This can cause problems. To solve this, pass the sample rate explicitly.
-    p_deviceConfig.sampleRate        = SampleRate;
+    p_deviceConfig.playback.channels = OutputChannels;
+    // The sample rate used to follow each track, which meant re-opening the device on every switch
+    // (and a source of pitch bugs). It is fixed now, the decoders resample instead.
+    p_deviceConfig.sampleRate        = OutputSampleRate;
     p_deviceConfig.dataCallback      = Callback;   // CallBack Function
-    p_deviceConfig.pUserData         = DoubleBuffering;   // Can be accessed from the device object (device.pUserData).
+    p_deviceConfig.pUserData         = UserData;   // Can be accessed from the device object (device.pUserData).
+    // Requests only, the backend may round them, see GetLatencyMs() for what we got
+    p_deviceConfig.periodSizeInMilliseconds = Profile.s_periodMilliseconds;
+    p_deviceConfig.periods                  = Profile.s_periods;
+    p_deviceConfig.performanceProfile       = Profile.s_performance;
 
 	// LOG_INFO("Audio Device -> Device Config Initialized.");
 	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DEVICE, "Set Config completed with Sample rate: ", p_deviceConfig.sampleRate,
 									"Hz, Format: ", p_deviceConfig.playback.format);
 }
 
-void AudioDevice::InitDevice(ma_decoder &Decoder) {
+void AudioDevice::InitDevice() {
+	// Already open: only hand over the new stream, the device must be stopped here
+	if (p_opened) {
+		p_device.pUserData = p_deviceConfig.pUserData;
+		return;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
     if (ma_device_init(nullptr, &this->p_deviceConfig, &p_device) != MA_SUCCESS) {
     	Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_DEVICE, "Error to init the Device.");
-        ma_decoder_uninit(&Decoder); // For Safety
+        return;
     }
-	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DEVICE, "Initialized.");
+	p_opened = true;
+
+	const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DEVICE, "Initialized in ", elapsed, " ms (previously paid on every track switch).");
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DEVICE, "Device buffer: ", p_device.playback.internalPeriods, " x ",
+				p_device.playback.internalPeriodSizeInFrames, " frames = ", GetLatencyMs(), " ms.");
+}
+
+bool AudioDevice::Start() {
+	if (!p_opened) {
+		return false;
+	}
+	return ma_device_is_started(&p_device) || ma_device_start(&p_device) == MA_SUCCESS;
+}
+
+void AudioDevice::Stop() {
+	if (p_opened) {
+		ma_device_stop(&p_device);
+	}
+}
+
+bool AudioDevice::IsStarted() const {
+	return p_opened && ma_device_is_started(&p_device);
+}
+
+double AudioDevice::GetLatencyMs() const {
+	if (!p_opened || p_device.playback.internalSampleRate == 0) {
+		return 0.0;
+	}
+	const auto frames = static_cast<double>(p_device.playback.internalPeriodSizeInFrames) * p_device.playback.internalPeriods;
+	return frames * 1000.0 / p_device.playback.internalSampleRate;
+}
+
+void AudioDevice::Close() {
+	if (p_opened) {
+		ma_device_uninit(&p_device);
+		p_opened = false;
+	}
 }
@@ -11,9 +11,17 @@
 
 // Basic Lib
 #include "../miniaudio/miniaudio.h"
+#include "LatencyProfile.hpp"
+#include "OutputSink.hpp"
 
-class AudioDevice {
+class AudioDevice : public OutputSink {
     public:
+	    // The device is opened once with a fixed output format, every decoder converts to it.
+	    // Track switches never re-open the device (that used to cost tens to hundreds of ms).
+	    static constexpr ma_format OutputFormat = ma_format_f32;
+	    static constexpr ma_uint32 OutputChannels = 2;
+	    static constexpr ma_uint32 OutputSampleRate = 48000;
+
 	    // Singleton Instance
 	    static AudioDevice& GetDeviceInstance() {
 	        static AudioDevice device;
@@ -25,21 +33,37 @@ class AudioDevice {
 		void operator=(const AudioDevice&) = delete;
 
 	    ma_device& GetDevice();
+	    bool IsOpen() const override { return p_opened; }
+
+	    // Decoder config that makes miniaudio convert any file to the device's output format
+	    static ma_decoder_config DecoderConfig();
+
+	    // The profile's period settings only reach the hardware when the device is (re)opened
+	    void InitDeviceConfig(const ma_device_data_proc& Callback, void* UserData,
+	                          const LatencyProfile& Profile = GetLatencyProfile(LatencyMode::Balanced)) override;
+	    void InitDevice() override;
+	    void Close() override;
+
+	    bool Start() override;
+	    void Stop() override; // miniaudio waits for the running callback
+	    bool IsStarted() const override;
 
-	    void InitDeviceConfig(const ma_uint32& SampleRate, const ma_format& Format,const ma_device_data_proc& Callback, ma_decoder& Decoder, void* DoubleBuffering);
-	    void InitDevice(ma_decoder& Decoder);
+	    // Hardware buffer the backend actually granted (period size x periods), 0 when closed
+	    double GetLatencyMs() const override;
+	    const char* GetName() const override { return "device"; }
 
 	private:
         ma_device p_device;
         ma_device_config p_deviceConfig;
+        bool p_opened = false;
 
         // Default constructor
         AudioDevice() : p_device{}, p_deviceConfig{} {}
 
         // Default Destructor
-        ~AudioDevice() {
-            ma_device_uninit(&p_device); // Free Device
+        ~AudioDevice() override {
+            Close(); // Free Device
         }
 };
 
-#endif //AUDIODEVICE_HPP
\ No newline at end of file
+#endif //AUDIODEVICE_HPP
@@ -0,0 +1,125 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: EventQueue.hpp
+ *  Lib: Beeplayer Core engine Lock-free Engine Event Queue definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-07-30
+ *  Type: Events, Core Engine
+ */
+
+#ifndef EVENTQUEUE_HPP
+#define EVENTQUEUE_HPP
+
+// Standard Lib
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+
+// What the engine threads tell the controller, each stamped with the ring index it happened at
+enum class EngineEventType : ma_uint8 {
+	DecodeEnded,    // 填充线程: the decoder returned MA_AT_END, s_frame is the ring index after its last frame
+	TrackEnded,     // 回调: the last frame of the track has been handed to the device and nothing follows
+	TrackAdvanced,  // 回调: played past a gapless splice (or crossfade) boundary
+	SeekCompleted,  // 回调: the first frame after a seek has been handed to the device
+	PrepareNext,    // 控制器: open and pre-decode the following track
+};
+
+struct EngineEvent {
+	EngineEventType s_type = EngineEventType::DecodeEnded;
+	ma_uint32 s_generation = 0; // Stream the event belongs to, events of a replaced stream are stale
+	ma_uint64 s_frame = 0;
+};
+
+// Bounded multi-producer / single-consumer queue (per-slot sequence numbers, no locks, no allocation
+// after construction). Push is safe from data_callback: a full queue drops the event instead of waiting,
+// and it only makes the wake-up system call when the consumer has announced that it is asleep.
+// The consumer blocks on the signal counter rather than polling.
+template <typename T, size_t Capacity>
+class EventQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+		static constexpr size_t CacheLineSize = 64;
+
+		EventQueue() {
+			for (size_t i = 0; i < Capacity; ++i) {
+				p_slots[i].s_sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		EventQueue(const EventQueue&) = delete;
+		EventQueue& operator=(const EventQueue&) = delete;
+
+		// Any thread. false if the queue is full (the consumer is far behind)
+		bool Push(const T& Value) {
+			size_t position = p_tail.load(std::memory_order_relaxed);
+			Slot* slot = nullptr;
+			for (;;) {
+				slot = &p_slots[position & (Capacity - 1)];
+				const size_t sequence = slot->s_sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+				if (diff == 0) {
+					// The slot is free for this position, claim it
+					if (p_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+						break;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					position = p_tail.load(std::memory_order_relaxed); // Another producer took it
+				}
+			}
+
+			slot->s_value = Value;
+			slot->s_sequence.store(position + 1, std::memory_order_release);
+			Wake();
+			return true;
+		}
+
+		// Consumer only
+		bool Pop(T& Out) {
+			Slot& slot = p_slots[p_head & (Capacity - 1)];
+			if (slot.s_sequence.load(std::memory_order_acquire) != p_head + 1) {
+				return false;
+			}
+			Out = slot.s_value;
+			slot.s_sequence.store(p_head + Capacity, std::memory_order_release); // Free for the next lap
+			++p_head;
+			return true;
+		}
+
+		// Consumer: read the signal, drain with Pop(), then Wait() on what was read so a push in between is not missed
+		ma_uint32 GetSignal() const { return p_signal.load(std::memory_order_acquire); }
+		void Wait(ma_uint32 Seen) {
+			// Announce first, then look again (both seq_cst, paired with Wake()): either this sees the new
+			// signal, or the producer sees the flag and notifies
+			p_waiting.store(true, std::memory_order_seq_cst);
+			if (p_signal.load(std::memory_order_seq_cst) == Seen) {
+				p_signal.wait(Seen, std::memory_order_acquire);
+			}
+			p_waiting.store(false, std::memory_order_relaxed);
+		}
+		// Wakes the consumer without an event (e.g. to let it see a stop flag). No system call unless it sleeps.
+		void Wake() {
+			p_signal.fetch_add(1, std::memory_order_seq_cst);
+			if (p_waiting.load(std::memory_order_seq_cst)) {
+				p_signal.notify_all();
+			}
+		}
+
+	private:
+		struct Slot {
+			std::atomic<size_t> s_sequence{0};
+			T s_value{};
+		};
+
+		Slot p_slots[Capacity];
+		alignas(CacheLineSize) std::atomic<size_t> p_tail{0}; // Shared by the producers
+		alignas(CacheLineSize) size_t p_head = 0;             // Owned by the consumer
+		alignas(CacheLineSize) std::atomic<ma_uint32> p_signal{0};
+		std::atomic<bool> p_waiting{false}; // Set by the consumer around its Wait()
+};
+
+#endif //EVENTQUEUE_HPP
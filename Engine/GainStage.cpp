@@ -0,0 +1,322 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: GainStage.cpp
+ *  Lib: Beeplayer Core engine f32 Gain Stage
+ *  Author: Romi Brooks
+ *  Date: 2025-07-28
+ *  Type: DSP, Core Engine
+ */
+
+#include "GainStage.hpp"
+
+// Standard Lib
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define BP_GAIN_X86 1
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define BP_TARGET_AVX2
+	#else
+		#define BP_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define BP_GAIN_NEON 1
+	#include <arm_neon.h>
+#endif
+
+namespace {
+	// The reference every other path must match bit for bit
+	void ScalarFrames(float* Samples, ma_uint64 First, ma_uint64 Frames, ma_uint32 Channels, float StartGain, float Step) {
+		for (ma_uint64 i = First; i < Frames; ++i) {
+			const float gain = StartGain + Step * static_cast<float>(i);
+			float* frame = Samples + i * Channels;
+			for (ma_uint32 c = 0; c < Channels; ++c) {
+				frame[c] = std::min(std::max(frame[c] * gain, -1.0f), 1.0f);
+			}
+		}
+	}
+
+	void ScalarMix(float* Dst, const float* Src, ma_uint64 First, ma_uint64 Frames, ma_uint32 Channels,
+				   float DstStart, float DstStep, float SrcStart, float SrcStep) {
+		for (ma_uint64 i = First; i < Frames; ++i) {
+			const float dstGain = DstStart + DstStep * static_cast<float>(i);
+			const float srcGain = SrcStart + SrcStep * static_cast<float>(i);
+			for (ma_uint64 s = i * Channels; s < (i + 1) * Channels; ++s) {
+				Dst[s] = Dst[s] * dstGain + Src[s] * srcGain;
+			}
+		}
+	}
+
+#ifdef BP_GAIN_X86
+	// max(lo, v) / min(hi, v) keep v when it is NaN, the same as std::max(v, lo) / std::min(v, hi)
+	inline __m128 Clamp128(__m128 V) {
+		return _mm_min_ps(_mm_set1_ps(1.0f), _mm_max_ps(_mm_set1_ps(-1.0f), V));
+	}
+
+	void Sse2Stereo(float* Samples, ma_uint64 Frames, float StartGain, float Step) {
+		// 4 lanes = 2 stereo frames, lanes 0/1 share a gain, so do lanes 2/3
+		const __m128 offsets = _mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f);
+		const __m128 start = _mm_set1_ps(StartGain);
+		const __m128 step = _mm_set1_ps(Step);
+		ma_uint64 i = 0;
+		for (; i + 2 <= Frames; i += 2) {
+			const __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), offsets);
+			const __m128 gain = _mm_add_ps(start, _mm_mul_ps(step, index));
+			float* p = Samples + i * 2;
+			_mm_storeu_ps(p, Clamp128(_mm_mul_ps(_mm_loadu_ps(p), gain)));
+		}
+		ScalarFrames(Samples, i, Frames, 2, StartGain, Step);
+	}
+
+	void Sse2Constant(float* Samples, ma_uint64 Count, float Gain) {
+		const __m128 gain = _mm_set1_ps(Gain);
+		ma_uint64 i = 0;
+		for (; i + 4 <= Count; i += 4) {
+			_mm_storeu_ps(Samples + i, Clamp128(_mm_mul_ps(_mm_loadu_ps(Samples + i), gain)));
+		}
+		ScalarFrames(Samples, i, Count, 1, Gain, 0.0f);
+	}
+
+	BP_TARGET_AVX2 inline __m256 Clamp256(__m256 V) {
+		return _mm256_min_ps(_mm256_set1_ps(1.0f), _mm256_max_ps(_mm256_set1_ps(-1.0f), V));
+	}
+
+	BP_TARGET_AVX2 void Avx2Stereo(float* Samples, ma_uint64 Frames, float StartGain, float Step) {
+		// 8 lanes = 4 stereo frames
+		const __m256 offsets = _mm256_set_ps(3.0f, 3.0f, 2.0f, 2.0f, 1.0f, 1.0f, 0.0f, 0.0f);
+		const __m256 start = _mm256_set1_ps(StartGain);
+		const __m256 step = _mm256_set1_ps(Step);
+		ma_uint64 i = 0;
+		for (; i + 4 <= Frames; i += 4) {
+			const __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), offsets);
+			const __m256 gain = _mm256_add_ps(start, _mm256_mul_ps(step, index));
+			float* p = Samples + i * 2;
+			_mm256_storeu_ps(p, Clamp256(_mm256_mul_ps(_mm256_loadu_ps(p), gain)));
+		}
+		ScalarFrames(Samples, i, Frames, 2, StartGain, Step);
+	}
+
+	BP_TARGET_AVX2 void Avx2Constant(float* Samples, ma_uint64 Count, float Gain) {
+		const __m256 gain = _mm256_set1_ps(Gain);
+		ma_uint64 i = 0;
+		for (; i + 8 <= Count; i += 8) {
+			_mm256_storeu_ps(Samples + i, Clamp256(_mm256_mul_ps(_mm256_loadu_ps(Samples + i), gain)));
+		}
+		ScalarFrames(Samples, i, Count, 1, Gain, 0.0f);
+	}
+
+	void Sse2MixStereo(float* Dst, const float* Src, ma_uint64 Frames, float DstStart, float DstStep, float SrcStart, float SrcStep) {
+		const __m128 offsets = _mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f);
+		const __m128 dstStart = _mm_set1_ps(DstStart);
+		const __m128 dstStep = _mm_set1_ps(DstStep);
+		const __m128 srcStart = _mm_set1_ps(SrcStart);
+		const __m128 srcStep = _mm_set1_ps(SrcStep);
+		ma_uint64 i = 0;
+		for (; i + 2 <= Frames; i += 2) {
+			const __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(i)), offsets);
+			const __m128 dstGain = _mm_add_ps(dstStart, _mm_mul_ps(dstStep, index));
+			const __m128 srcGain = _mm_add_ps(srcStart, _mm_mul_ps(srcStep, index));
+			float* d = Dst + i * 2;
+			const __m128 a = _mm_mul_ps(_mm_loadu_ps(d), dstGain);
+			const __m128 b = _mm_mul_ps(_mm_loadu_ps(Src + i * 2), srcGain);
+			_mm_storeu_ps(d, _mm_add_ps(a, b));
+		}
+		ScalarMix(Dst, Src, i, Frames, 2, DstStart, DstStep, SrcStart, SrcStep);
+	}
+
+	BP_TARGET_AVX2 void Avx2MixStereo(float* Dst, const float* Src, ma_uint64 Frames, float DstStart, float DstStep, float SrcStart, float SrcStep) {
+		const __m256 offsets = _mm256_set_ps(3.0f, 3.0f, 2.0f, 2.0f, 1.0f, 1.0f, 0.0f, 0.0f);
+		const __m256 dstStart = _mm256_set1_ps(DstStart);
+		const __m256 dstStep = _mm256_set1_ps(DstStep);
+		const __m256 srcStart = _mm256_set1_ps(SrcStart);
+		const __m256 srcStep = _mm256_set1_ps(SrcStep);
+		ma_uint64 i = 0;
+		for (; i + 4 <= Frames; i += 4) {
+			const __m256 index = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(i)), offsets);
+			const __m256 dstGain = _mm256_add_ps(dstStart, _mm256_mul_ps(dstStep, index));
+			const __m256 srcGain = _mm256_add_ps(srcStart, _mm256_mul_ps(srcStep, index));
+			float* d = Dst + i * 2;
+			const __m256 a = _mm256_mul_ps(_mm256_loadu_ps(d), dstGain);
+			const __m256 b = _mm256_mul_ps(_mm256_loadu_ps(Src + i * 2), srcGain);
+			_mm256_storeu_ps(d, _mm256_add_ps(a, b));
+		}
+		ScalarMix(Dst, Src, i, Frames, 2, DstStart, DstStep, SrcStart, SrcStep);
+	}
+
+	bool CpuHasAvx2() {
+	#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) return false; // OS saves the YMM state
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	#else
+		return __builtin_cpu_supports("avx2");
+	#endif
+	}
+#endif
+
+#ifdef BP_GAIN_NEON
+	// Compare-select instead of vmaxq/vminq so NaN and signed zeros come out exactly as in the scalar path
+	inline float32x4_t ClampNeon(float32x4_t V) {
+		const float32x4_t lo = vdupq_n_f32(-1.0f);
+		const float32x4_t hi = vdupq_n_f32(1.0f);
+		V = vbslq_f32(vcltq_f32(V, lo), lo, V);
+		return vbslq_f32(vcltq_f32(hi, V), hi, V);
+	}
+
+	void NeonStereo(float* Samples, ma_uint64 Frames, float StartGain, float Step) {
+		const float offsetValues[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+		const float32x4_t offsets = vld1q_f32(offsetValues);
+		const float32x4_t start = vdupq_n_f32(StartGain);
+		const float32x4_t step = vdupq_n_f32(Step);
+		ma_uint64 i = 0;
+		for (; i + 2 <= Frames; i += 2) {
+			const float32x4_t index = vaddq_f32(vdupq_n_f32(static_cast<float>(i)), offsets);
+			const float32x4_t gain = vaddq_f32(start, vmulq_f32(step, index));
+			float* p = Samples + i * 2;
+			vst1q_f32(p, ClampNeon(vmulq_f32(vld1q_f32(p), gain)));
+		}
+		ScalarFrames(Samples, i, Frames, 2, StartGain, Step);
+	}
+
+	void NeonConstant(float* Samples, ma_uint64 Count, float Gain) {
+		const float32x4_t gain = vdupq_n_f32(Gain);
+		ma_uint64 i = 0;
+		for (; i + 4 <= Count; i += 4) {
+			vst1q_f32(Samples + i, ClampNeon(vmulq_f32(vld1q_f32(Samples + i), gain)));
+		}
+		ScalarFrames(Samples, i, Count, 1, Gain, 0.0f);
+	}
+
+	void NeonMixStereo(float* Dst, const float* Src, ma_uint64 Frames, float DstStart, float DstStep, float SrcStart, float SrcStep) {
+		const float offsetValues[4] = {0.0f, 0.0f, 1.0f, 1.0f};
+		const float32x4_t offsets = vld1q_f32(offsetValues);
+		const float32x4_t dstStart = vdupq_n_f32(DstStart);
+		const float32x4_t dstStep = vdupq_n_f32(DstStep);
+		const float32x4_t srcStart = vdupq_n_f32(SrcStart);
+		const float32x4_t srcStep = vdupq_n_f32(SrcStep);
+		ma_uint64 i = 0;
+		for (; i + 2 <= Frames; i += 2) {
+			const float32x4_t index = vaddq_f32(vdupq_n_f32(static_cast<float>(i)), offsets);
+			const float32x4_t dstGain = vaddq_f32(dstStart, vmulq_f32(dstStep, index));
+			const float32x4_t srcGain = vaddq_f32(srcStart, vmulq_f32(srcStep, index));
+			float* d = Dst + i * 2;
+			const float32x4_t a = vmulq_f32(vld1q_f32(d), dstGain);
+			const float32x4_t b = vmulq_f32(vld1q_f32(Src + i * 2), srcGain);
+			vst1q_f32(d, vaddq_f32(a, b));
+		}
+		ScalarMix(Dst, Src, i, Frames, 2, DstStart, DstStep, SrcStart, SrcStep);
+	}
+#endif
+}
+
+bool GainStage::IsSupported(Path Using) {
+	switch (Using) {
+		case Path::Scalar: return true;
+#ifdef BP_GAIN_X86
+		case Path::SSE2: return true; // Baseline on every x86-64 CPU
+		case Path::AVX2: {
+			static const bool avx2 = CpuHasAvx2();
+			return avx2;
+		}
+#endif
+#ifdef BP_GAIN_NEON
+		case Path::NEON: return true;
+#endif
+		default: return false;
+	}
+}
+
+GainStage::Path GainStage::ActivePath() {
+	static const Path path = IsSupported(Path::AVX2) ? Path::AVX2
+						   : IsSupported(Path::NEON) ? Path::NEON
+						   : IsSupported(Path::SSE2) ? Path::SSE2
+						   : Path::Scalar;
+	return path;
+}
+
+const char* GainStage::PathName(Path Using) {
+	switch (Using) {
+		case Path::SSE2: return "SSE2";
+		case Path::AVX2: return "AVX2";
+		case Path::NEON: return "NEON";
+		default: return "Scalar";
+	}
+}
+
+void GainStage::Apply(float *Samples, ma_uint64 Frames, ma_uint32 Channels, float StartGain, float EndGain) {
+	ApplyWith(ActivePath(), Samples, Frames, Channels, StartGain, EndGain);
+}
+
+void GainStage::ApplyWith(Path Using, float *Samples, ma_uint64 Frames, ma_uint32 Channels, float StartGain, float EndGain) {
+	if (Frames == 0) return;
+	const float step = (EndGain - StartGain) / static_cast<float>(Frames);
+	const bool constant = StartGain == EndGain;
+	const float gain = StartGain + 0.0f; // What the scalar formula yields for every frame when step is 0 (-0 becomes +0)
+
+	// SIMD covers a constant gain on any layout and a ramp on stereo (the engine's output), scalar the rest
+	if (!IsSupported(Using) || (!constant && Channels != 2)) {
+		Using = Path::Scalar;
+	}
+
+	switch (Using) {
+#ifdef BP_GAIN_X86
+		case Path::AVX2:
+			constant ? Avx2Constant(Samples, Frames * Channels, gain) : Avx2Stereo(Samples, Frames, StartGain, step);
+			return;
+		case Path::SSE2:
+			constant ? Sse2Constant(Samples, Frames * Channels, gain) : Sse2Stereo(Samples, Frames, StartGain, step);
+			return;
+#endif
+#ifdef BP_GAIN_NEON
+		case Path::NEON:
+			constant ? NeonConstant(Samples, Frames * Channels, gain) : NeonStereo(Samples, Frames, StartGain, step);
+			return;
+#endif
+		default:
+			ScalarFrames(Samples, 0, Frames, Channels, StartGain, step);
+			return;
+	}
+}
+
+void GainStage::Mix(float *Dst, const float *Src, ma_uint64 Frames, ma_uint32 Channels,
+					float DstStartGain, float DstEndGain, float SrcStartGain, float SrcEndGain) {
+	MixWith(ActivePath(), Dst, Src, Frames, Channels, DstStartGain, DstEndGain, SrcStartGain, SrcEndGain);
+}
+
+void GainStage::MixWith(Path Using, float *Dst, const float *Src, ma_uint64 Frames, ma_uint32 Channels,
+						float DstStartGain, float DstEndGain, float SrcStartGain, float SrcEndGain) {
+	if (Frames == 0) return;
+	const float dstStep = (DstEndGain - DstStartGain) / static_cast<float>(Frames);
+	const float srcStep = (SrcEndGain - SrcStartGain) / static_cast<float>(Frames);
+
+	// SIMD covers stereo (the engine's output), scalar the rest
+	if (!IsSupported(Using) || Channels != 2) {
+		Using = Path::Scalar;
+	}
+
+	switch (Using) {
+#ifdef BP_GAIN_X86
+		case Path::AVX2:
+			Avx2MixStereo(Dst, Src, Frames, DstStartGain, dstStep, SrcStartGain, srcStep);
+			return;
+		case Path::SSE2:
+			Sse2MixStereo(Dst, Src, Frames, DstStartGain, dstStep, SrcStartGain, srcStep);
+			return;
+#endif
+#ifdef BP_GAIN_NEON
+		case Path::NEON:
+			NeonMixStereo(Dst, Src, Frames, DstStartGain, dstStep, SrcStartGain, srcStep);
+			return;
+#endif
+		default:
+			ScalarMix(Dst, Src, 0, Frames, Channels, DstStartGain, dstStep, SrcStartGain, srcStep);
+			return;
+	}
+}
@@ -0,0 +1,50 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: GainStage.hpp
+ *  Lib: Beeplayer Core engine f32 Gain Stage definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-07-28
+ *  Type: DSP, Core Engine
+ */
+
+#ifndef GAINSTAGE_HPP
+#define GAINSTAGE_HPP
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+
+// Gain with a linear ramp and clipping protection on interleaved f32, run inside data_callback.
+// Every SIMD path produces exactly the bits the scalar path does: the same multiply and add per
+// sample (never fused, the file is built with FP contraction off) and the same compare-select clamp.
+// Frame i of a block gets StartGain + (EndGain - StartGain) / Frames * i, so the next block starting
+// at EndGain continues the ramp without a step.
+
+class GainStage {
+	public:
+		enum class Path {
+			Scalar,
+			SSE2,
+			AVX2,
+			NEON,
+		};
+
+		// Picks the best path this CPU supports (decided once)
+		static void Apply(float* Samples, ma_uint64 Frames, ma_uint32 Channels, float StartGain, float EndGain);
+
+		// Forces a path, falls back to scalar when the CPU (or build) lacks it. For tests and benchmarks.
+		static void ApplyWith(Path Using, float* Samples, ma_uint64 Frames, ma_uint32 Channels, float StartGain, float EndGain);
+
+		// Crossfade mix: Dst = Dst * DstGain + Src * SrcGain, both gains ramped across the block like Apply's
+		// (frame i gets Start + (End - Start) / Frames * i). No clamp, so the volume still has the headroom:
+		// the callback runs the gain stage over mixed frames even at unity gain, which clamps them.
+		// Same bit-for-bit guarantee across paths.
+		static void Mix(float* Dst, const float* Src, ma_uint64 Frames, ma_uint32 Channels,
+						float DstStartGain, float DstEndGain, float SrcStartGain, float SrcEndGain);
+		static void MixWith(Path Using, float* Dst, const float* Src, ma_uint64 Frames, ma_uint32 Channels,
+							float DstStartGain, float DstEndGain, float SrcStartGain, float SrcEndGain);
+
+		static Path ActivePath();
+		static bool IsSupported(Path Using);
+		static const char* PathName(Path Using);
+};
+
+#endif //GAINSTAGE_HPP
@@ -0,0 +1,44 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LatencyProfile.hpp
+ *  Lib: Beeplayer Core engine Output Latency Profiles
+ *  Author: Romi Brooks
+ *  Date: 2025-07-26
+ *  Type: Device, Buffers, Core Engine
+ */
+
+#ifndef LATENCYPROFILE_HPP
+#define LATENCYPROFILE_HPP
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+
+// A profile sets everything that decides how far ahead of the speaker we run, as one unit:
+// the device period and period count (hardware buffer), and the ring capacity and refill
+// watermarks (software buffer). Smaller means snappier seeks/volume and more wakeups.
+
+enum class LatencyMode {
+	LowLatency = 0,
+	Balanced = 1,
+	PowerSave = 2,
+};
+
+struct LatencyProfile {
+	const char* s_name;
+	ma_uint32 s_periodMilliseconds;       // 设备周期
+	ma_uint32 s_periods;                  // 设备周期数
+	ma_performance_profile s_performance;
+	float s_ringSeconds;                  // 环形缓冲区容量
+	float s_lowWatermarkSeconds;          // 低于此水位时唤醒填充线程
+	float s_highWatermarkSeconds;         // 填充到此水位后休眠
+};
+
+inline const LatencyProfile& GetLatencyProfile(LatencyMode Mode) {
+	static constexpr LatencyProfile profiles[] = {
+		{"Low latency", 5, 2, ma_performance_profile_low_latency, 0.25f, 0.06f, 0.2f},
+		{"Balanced", 10, 3, ma_performance_profile_low_latency, 1.0f, 0.25f, 0.9f},
+		{"Power save", 40, 3, ma_performance_profile_conservative, 4.0f, 1.0f, 3.6f},
+	};
+	return profiles[static_cast<int>(Mode)];
+}
+
+#endif //LATENCYPROFILE_HPP
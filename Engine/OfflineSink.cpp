@@ -0,0 +1,191 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: OfflineSink.cpp
+ *  Lib: Beeplayer Core engine Offline Output Sinks (null / WAV file)
+ *  Author: Romi Brooks
+ *  Date: 2025-08-04
+ *  Type: Device, Core Engine
+ */
+
+#include "OfflineSink.hpp"
+
+// Standard Lib
+#include <chrono>
+#include <utility>
+
+// Basic Lib
+#include "Buffering.hpp"
+#include "Device.hpp"
+#include "../Log/LogSystem.hpp"
+
+OfflineSink::OfflineSink(ma_uint32 PeriodFrames, bool Paced)
+	: p_device{}, p_requestedPeriodFrames(PeriodFrames), p_paced(Paced) {}
+
+OfflineSink::~OfflineSink() {
+	Close();
+}
+
+void OfflineSink::InitDeviceConfig(const ma_device_data_proc &Callback, void* UserData, const LatencyProfile& Profile) {
+	p_callback = Callback;
+	p_pendingUserData = UserData;
+	if (!p_opened) {
+		p_periodFrames = p_requestedPeriodFrames != 0 ? p_requestedPeriodFrames
+		                                              : AudioDevice::OutputSampleRate * Profile.s_periodMilliseconds / 1000;
+	}
+}
+
+void OfflineSink::InitDevice() {
+	p_device.pUserData = p_pendingUserData;
+	if (p_opened) {
+		return;
+	}
+	if (p_callback == nullptr || p_periodFrames == 0 || !OnOpen()) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_DEVICE, "Error to open the ", GetName(), " sink.");
+		return;
+	}
+	p_period.assign(static_cast<size_t>(p_periodFrames) * AudioDevice::OutputChannels, 0.0f);
+	p_framesRendered.store(0, std::memory_order_relaxed);
+	p_stalls.store(0, std::memory_order_relaxed);
+	p_opened = true;
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DEVICE, "Offline ", GetName(), " sink: ", p_periodFrames, " frames per period, ",
+				p_paced ? "paced." : "as fast as the engine delivers.");
+}
+
+void OfflineSink::Close() {
+	Stop();
+	p_opened = false;
+}
+
+bool OfflineSink::Start() {
+	if (!p_opened) {
+		return false;
+	}
+	if (p_running.load(std::memory_order_relaxed)) {
+		return true;
+	}
+	if (p_thread.joinable()) {
+		p_thread.join(); // Stopped on its own (Consume() failed)
+	}
+	p_trackEnded = false;
+	p_running.store(true, std::memory_order_relaxed);
+	p_thread = std::thread(&OfflineSink::Run, this);
+	return true;
+}
+
+void OfflineSink::Stop() {
+	p_running.store(false, std::memory_order_relaxed);
+	if (p_thread.joinable()) {
+		p_thread.join();
+	}
+}
+
+double OfflineSink::GetLatencyMs() const {
+	return p_opened ? p_periodFrames * 1000.0 / AudioDevice::OutputSampleRate : 0.0;
+}
+
+bool OfflineSink::WaitForPeriod() {
+	const auto* context = static_cast<const StreamContext*>(p_device.pUserData);
+	if (context == nullptr || context->s_owner == nullptr || context->s_ring == nullptr) {
+		return true;
+	}
+	AudioBuffering& buffer = *context->s_owner;
+	const RingBuffer& ring = *context->s_ring;
+
+	// Enough in the ring, or the track ends and nothing will be spliced (the callback pads the tail).
+	// A gapless end waits for the splice like a device's ring would have.
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(StallTimeoutMs);
+	while (p_running.load(std::memory_order_relaxed)) {
+		// Paused and faded out, or past the end of the track until the controller starts the next stream:
+		// a device would play silence here, a render skips it (the callback runs on this thread, HoldOutput() is ours to ask)
+		const bool idle = p_trackEnded ? ring.AvailableRead() < p_periodFrames && !buffer.IsEndDecoded()
+		                               : buffer.HoldOutput();
+		if (idle) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(IdlePollMs));
+			deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(StallTimeoutMs);
+			continue;
+		}
+		p_trackEnded = false;
+
+		if (ring.AvailableRead() >= p_periodFrames || (buffer.IsEndDecoded() && !buffer.IsGapless())) {
+			return true;
+		}
+		if (std::chrono::steady_clock::now() >= deadline) {
+			return false;
+		}
+		buffer.RequestRefill();
+		std::this_thread::yield();
+	}
+	return true;
+}
+
+void OfflineSink::Run() {
+	using Clock = std::chrono::steady_clock;
+	const auto period = std::chrono::nanoseconds(static_cast<ma_int64>(p_periodFrames) * 1000000000 / AudioDevice::OutputSampleRate);
+	auto next = Clock::now();
+
+	while (p_running.load(std::memory_order_relaxed)) {
+		const auto* context = static_cast<const StreamContext*>(p_device.pUserData);
+		bool endInRing = false;
+		if (p_paced) {
+			std::this_thread::sleep_until(next);
+			next += period;
+		} else {
+			if (!WaitForPeriod()) {
+				p_stalls.fetch_add(1, std::memory_order_relaxed);
+			}
+			endInRing = context != nullptr && context->s_owner != nullptr && context->s_owner->IsEndDecoded();
+		}
+		if (!p_running.load(std::memory_order_relaxed)) {
+			break; // Stopped while waiting, nothing of this period is rendered
+		}
+
+		p_callback(&p_device, p_period.data(), nullptr, p_periodFrames);
+		p_framesRendered.fetch_add(p_periodFrames, std::memory_order_relaxed);
+
+		// The end went out in this period (the callback cleared it) and nothing was spliced behind it
+		if (endInRing && !context->s_owner->IsEndDecoded() && context->s_ring->AvailableRead() == 0) {
+			p_trackEnded = true;
+		}
+		if (!Consume(p_period.data(), p_periodFrames)) {
+			p_running.store(false, std::memory_order_relaxed); // Start() can begin again
+			break;
+		}
+	}
+}
+
+bool NullSink::Consume(const float* /*Samples*/, ma_uint32 /*Frames*/) {
+	return true;
+}
+
+WavSink::WavSink(std::string FilePath, ma_uint32 PeriodFrames, bool Paced)
+	: OfflineSink(PeriodFrames, Paced), p_filePath(std::move(FilePath)), p_encoder{} {}
+
+WavSink::~WavSink() {
+	Close(); // Stop the thread before the encoder goes away
+	if (p_encoderOpen) {
+		ma_encoder_uninit(&p_encoder); // Writes the final chunk sizes
+		p_encoderOpen = false;
+	}
+}
+
+bool WavSink::OnOpen() {
+	if (p_encoderOpen) {
+		return true;
+	}
+	const ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, AudioDevice::OutputFormat,
+	                                                        AudioDevice::OutputChannels, AudioDevice::OutputSampleRate);
+	if (ma_encoder_init_file(p_filePath.c_str(), &config, &p_encoder) != MA_SUCCESS) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_DEVICE, "Could not create: ", p_filePath);
+		return false;
+	}
+	p_encoderOpen = true;
+	return true;
+}
+
+bool WavSink::Consume(const float* Samples, ma_uint32 Frames) {
+	ma_uint64 written = 0;
+	if (ma_encoder_write_pcm_frames(&p_encoder, Samples, Frames, &written) != MA_SUCCESS || written != Frames) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_DEVICE, "Write failed, stopped rendering to: ", p_filePath);
+		return false;
+	}
+	return true;
+}
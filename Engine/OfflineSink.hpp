@@ -0,0 +1,119 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: OfflineSink.hpp
+ *  Lib: Beeplayer Core engine Offline Output Sinks definitions (null / WAV file)
+ *  Author: Romi Brooks
+ *  Date: 2025-08-04
+ *  Type: Device, Core Engine
+ */
+
+#ifndef OFFLINESINK_HPP
+#define OFFLINESINK_HPP
+
+// Standard Lib
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+#include "OutputSink.hpp"
+
+// Runs data_callback on its own thread instead of a sound card, one period at a time, in the device's
+// output format. No audio hardware is needed (headless build agents, benchmarks, CI).
+//
+// Unpaced (the default) it pulls as fast as the engine delivers: before each period it waits for the
+// filler to have a full period in the ring, so nothing is rendered as an underrun and the output is the
+// same on every run. It renders nothing while paused (once the fade-out is out) and nothing between the
+// end of a track and the controller's switch to the next, time the engine spends there leaves no gap.
+// Paced, it sleeps to the period like a real device and underruns (and plays silence) like one.
+// The user data must be the engine's StreamContext (it is what data_callback takes anyway).
+// Derived sinks call Close() in their destructor, the thread must not outlive their Consume().
+class OfflineSink : public OutputSink {
+	public:
+		static constexpr ma_uint32 DefaultPeriodFrames = 480; // 10 ms at the output rate
+		static constexpr int StallTimeoutMs = 250; // Longest wait for the filler (or a splice) before rendering an underrun
+		static constexpr int IdlePollMs = 1;       // Paused or between tracks: how often to look again
+
+		// PeriodFrames 0: take the period from the latency profile, like the device does
+		explicit OfflineSink(ma_uint32 PeriodFrames = DefaultPeriodFrames, bool Paced = false);
+		~OfflineSink() override;
+
+		OfflineSink(const OfflineSink&) = delete;
+		OfflineSink& operator=(const OfflineSink&) = delete;
+
+		void InitDeviceConfig(const ma_device_data_proc& Callback, void* UserData,
+		                      const LatencyProfile& Profile = GetLatencyProfile(LatencyMode::Balanced)) override;
+		void InitDevice() override;
+		void Close() override;
+
+		bool Start() override;
+		void Stop() override;
+		bool IsStarted() const override { return p_running.load(std::memory_order_relaxed); }
+		bool IsOpen() const override { return p_opened; }
+
+		// One period, a paced sink behaves like a device with a single period buffer
+		double GetLatencyMs() const override;
+
+		ma_uint32 GetPeriodFrames() const { return p_periodFrames; }
+		// Frames handed out by the callback since the sink was opened, readable from any thread
+		ma_uint64 GetFramesRendered() const { return p_framesRendered.load(std::memory_order_relaxed); }
+		// Periods rendered with fewer frames in the ring than asked for (silence was padded in)
+		ma_uint64 GetStalls() const { return p_stalls.load(std::memory_order_relaxed); }
+
+	protected:
+		// Called on every (re)open, false fails it
+		virtual bool OnOpen() { return true; }
+		// Sink thread: what to do with a rendered period, false stops rendering
+		virtual bool Consume(const float* Samples, ma_uint32 Frames) = 0;
+
+	private:
+		ma_device p_device;              // Only pUserData is filled in, it is all data_callback reads
+		ma_device_data_proc p_callback = nullptr;
+		void* p_pendingUserData = nullptr;
+		ma_uint32 p_requestedPeriodFrames;
+		ma_uint32 p_periodFrames = DefaultPeriodFrames;
+		bool p_paced;
+		bool p_opened = false;
+
+		std::thread p_thread;
+		std::atomic<bool> p_running{false};
+		std::atomic<ma_uint64> p_framesRendered{0};
+		std::atomic<ma_uint64> p_stalls{0};
+		std::vector<float> p_period;
+		bool p_trackEnded = false;       // Sink thread: the last frame went out, nothing to render until a new stream fills the ring
+
+		void Run();
+		bool WaitForPeriod(); // true when a full period is in the ring
+};
+
+// Discards the output: measures how fast the engine can produce audio (x realtime)
+class NullSink : public OfflineSink {
+	public:
+		using OfflineSink::OfflineSink;
+		~NullSink() override { Close(); }
+		const char* GetName() const override { return "null"; }
+
+	protected:
+		bool Consume(const float* Samples, ma_uint32 Frames) override;
+};
+
+// Writes the output to a 32 bit float WAV file, for comparing renders bit for bit. The file is created
+// on the first open and stays open across re-opens (latency profile changes), it is finalized on destruction.
+class WavSink : public OfflineSink {
+	public:
+		explicit WavSink(std::string FilePath, ma_uint32 PeriodFrames = DefaultPeriodFrames, bool Paced = false);
+		~WavSink() override;
+		const char* GetName() const override { return "wav"; }
+
+	protected:
+		bool OnOpen() override;
+		bool Consume(const float* Samples, ma_uint32 Frames) override;
+
+	private:
+		std::string p_filePath;
+		ma_encoder p_encoder;
+		bool p_encoderOpen = false;
+};
+
+#endif //OFFLINESINK_HPP
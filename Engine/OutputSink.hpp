@@ -0,0 +1,40 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: OutputSink.hpp
+ *  Lib: Beeplayer Core engine Output Sink interface definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-08-04
+ *  Type: Device, Core Engine
+ */
+
+#ifndef OUTPUTSINK_HPP
+#define OUTPUTSINK_HPP
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+#include "LatencyProfile.hpp"
+
+// Whatever pulls data_callback: the sound card (AudioDevice), or an offline sink that runs the callback
+// on its own thread (NullSink, WavSink). The output format is always AudioDevice's fixed one.
+// Same life cycle as the device: config, open, then start / stop any number of times, close.
+class OutputSink {
+	public:
+		virtual ~OutputSink() = default;
+
+		// The profile's period settings only take effect when the sink is (re)opened
+		virtual void InitDeviceConfig(const ma_device_data_proc& Callback, void* UserData,
+		                              const LatencyProfile& Profile = GetLatencyProfile(LatencyMode::Balanced)) = 0;
+		// Already open: only hands over the new user data, the sink must be stopped here
+		virtual void InitDevice() = 0;
+		virtual void Close() = 0;
+
+		virtual bool Start() = 0;
+		virtual void Stop() = 0; // Returns once the callback is no longer running
+		virtual bool IsStarted() const = 0;
+		virtual bool IsOpen() const = 0;
+
+		// What sits between the callback and the listener (period size x periods), 0 when closed
+		virtual double GetLatencyMs() const = 0;
+		virtual const char* GetName() const = 0;
+};
+
+#endif //OUTPUTSINK_HPP
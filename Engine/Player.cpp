@@ -9,6 +9,7 @@
 #include "Player.hpp"
 
 // Standard Lib
+#include <chrono>
 #include <thread>
 
 // Basic Lib
@@ -17,8 +18,10 @@
 #include "../Log/LogSystem.hpp"
 
 
-void AudioPlayer::Play(AudioDevice &Device, AudioDecoder &Decoder, Status &Timer, AudioBuffering &Buffer) const {
-	if (ma_device_start(&Device.GetDevice()) != MA_SUCCESS) {
+void AudioPlayer::Play(OutputSink &Device, AudioBuffering &Buffer) const {
+	// Resuming from a pause is a fade-in in the callback, the device only starts after a switch or init
+	Buffer.SetPaused(false);
+	if (!Device.Start()) {
 		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_PLAYER, "Error when play the file.");
              return;
 	}
@@ -26,31 +29,34 @@ void AudioPlayer::Play(AudioDevice &Device, AudioDecoder &Decoder, Status &Timer
 	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Now Playing: ", this->GetName());
 }
 
-void AudioPlayer::Pause(AudioDevice &Device) {
-	if (ma_device_is_started(&Device.GetDevice())) {
-		ma_device_stop(&Device.GetDevice());
-	} else {
-		ma_device_start(&Device.GetDevice());
-	}
+void AudioPlayer::Pause(AudioBuffering &Buffer) {
+	// Stopping the device clicked and cost backend start-up latency on every resume
+	Buffer.SetPaused(true);
 }
 
-void AudioPlayer::Seek(AudioDecoder &Decoder,ma_uint64 FrameIndex) {
-	ma_decoder_seek_to_pcm_frame(&Decoder.GetDecoder(),FrameIndex);
+// The decoder belongs to the filler thread, so the seek is queued there instead of done here
+void AudioPlayer::Seek(AudioBuffering &Buffer, ma_uint64 FrameIndex) {
+	Buffer.RequestSeek(FrameIndex);
 }
 
 void AudioPlayer::InitDecoder(const Path& Pather, AudioDecoder& Decoder) {
-	Decoder.InitDecoder(Pather.CurrentFilePath());
+	const ma_decoder_config config = AudioDevice::DecoderConfig();
+	Decoder.InitDecoder(Pather.CurrentFilePath(), &config);
 	SetName(Path::GetFileName(Pather.CurrentFilePath()));
 }
 
-void AudioPlayer::InitDevice(AudioDecoder& Decoder, AudioDevice &Device, const ma_device_data_proc &Callback,
-							 AudioBuffering &Buffer) {
-	Device.InitDeviceConfig(Decoder.GetDecoder().outputSampleRate, Decoder.GetDecoder().outputFormat, Callback, Decoder.GetDecoder(), &Buffer);
-	Device.InitDevice(Decoder.GetDecoder());
+void AudioPlayer::InitDevice(OutputSink &Device, const ma_device_data_proc &Callback, AudioBuffering &Buffer,
+							 const LatencyProfile& Profile) {
+	Device.InitDeviceConfig(Callback, &Buffer.GetStreamContext(), Profile);
+	Device.InitDevice();
+	Buffer.SetDeviceLatencyMs(Device.GetLatencyMs()); // What the backend granted, for the playhead clock
 }
 
-void AudioPlayer::Switch(Path &Pather, AudioDecoder &Decoder, AudioDevice &Device, const ma_device_data_proc &Callback,
-						 Status &Timer, AudioBuffering &Buffer, SwitchAction SwitchCode) {
+void AudioPlayer::Switch(Path &Pather, AudioDecoder &Decoder, OutputSink &Device, Status &Timer, AudioBuffering &Buffer,
+						 SwitchAction SwitchCode) {
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+
 	switch (SwitchCode) {
 		// Set To the next file.
 		case SwitchAction::NEXT: {
@@ -78,39 +84,41 @@ void AudioPlayer::Switch(Path &Pather, AudioDecoder &Decoder, AudioDevice &Devic
 
 	// ZERO: Make sure the data user all cleaned.
 	Clean(Buffer, Timer, Decoder, Device);
+	const auto cleaned = Clock::now();
 
-
-	// First: Init the Decoder From the file
-	Decoder.InitDecoder(Pather.CurrentFilePath());
+	// First: Init the Decoder From the file, converting to the device's fixed output format
+	const ma_decoder_config config = AudioDevice::DecoderConfig();
+	Decoder.InitDecoder(Pather.CurrentFilePath(), &config);
 	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Reinit Decoder completed.");
+	const auto decoded = Clock::now();
 
-	// Second: Init the Device to make sure there is a device to play the audio
-	Device.InitDeviceConfig(Decoder.GetDecoder().outputSampleRate, Decoder.GetDecoder().outputFormat, Callback,
-							Decoder.GetDecoder(), &Buffer);
-	Device.InitDevice(Decoder.GetDecoder());
-	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Reinit the Device completed.");
-
-	// Rerun the Time Counter and double buffering progress
+	// Second: The device stays open across switches, only the stream behind it changes.
+	// Rerun the Time Counter and ring buffering progress
 	Timer.SetFileLength(Decoder); // reset the file length
-	Buffer.GetBufferThread() = std::thread(&AudioBuffering::BufferFiller, &Buffer, &Decoder.GetDecoder());
-	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Rerun the double buffering progress.");
+	Buffer.StartFiller(&Decoder.GetDecoder(), Decoder.GetSeekIndex(), Decoder.GetLengthInFrames(), Pather.CurrentTrackId());
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Rerun the ring buffering progress.");
 
 	// Third: Just Playing the file from decoder and device
-	Play(Device, Decoder, Timer, Buffer);
+	Play(Device, Buffer);
 	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Start Playing.");
+
+	const auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+	const auto done = Clock::now();
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PLAYER, "Switch took ", ms(done - start), " ms (clean ", ms(cleaned - start),
+				" ms, decoder ", ms(decoded - cleaned), " ms, filler and start ", ms(done - decoded), " ms).");
 }
 
 // This function write for switch actions,
-void AudioPlayer::Clean(AudioBuffering &Buffer, Status& Timer , AudioDecoder &Decoder, AudioDevice &Device){
-	ma_device_uninit(&Device.GetDevice());
+void AudioPlayer::Clean(AudioBuffering &Buffer, Status& Timer , AudioDecoder &Decoder, OutputSink &Device){
+	Device.Stop(); // Keep the device open, just stop pulling from the old stream
+	Buffer.ResetBuffer(); // Stop the filler before its decoder goes away
 	ma_decoder_uninit(&Decoder.GetDecoder());
 	Timer.ResetStatus();
-	Buffer.ResetBuffer();
 }
 
 // If the exec will be exited, try to this function call
-void AudioPlayer::Exit(AudioDevice &Device, AudioDecoder &Decoder) {
-	ma_device_stop(&Device.GetDevice());
-	ma_device_uninit(&Device.GetDevice());
+void AudioPlayer::Exit(OutputSink &Device, AudioDecoder &Decoder) {
+	Device.Stop();
+	Device.Close();
 	ma_decoder_uninit(&Decoder.GetDecoder());
 }
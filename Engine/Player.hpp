@@ -13,6 +13,7 @@
 // Basic Lib
 #include "Decoder.hpp"
 #include "Device.hpp"
+#include "OutputSink.hpp"
 #include "Status.hpp"
 #include "Buffering.hpp"
 #include "../FileSystem/Path.hpp"
@@ -35,9 +36,9 @@ class AudioPlayer {
 		// static void StaticCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount);
 		// void InstanceCallback(const ma_device *pDevice, void *pOutput, const void *pInput, ma_uint32 frameCount);
 
-		void Play(AudioDevice &Device, AudioDecoder &Decoder, Status& Timer, AudioBuffering& Buffer) const;
-		void Pause(AudioDevice& Device);
-		void Seek(AudioDecoder& Decoder,ma_uint64 FrameIndex);
+		void Play(OutputSink &Device, AudioBuffering& Buffer) const;
+		void Pause(AudioBuffering& Buffer); // Fades out, the device keeps running on silence
+		void Seek(AudioBuffering& Buffer, ma_uint64 FrameIndex);
 
 		std::string GetName() const { return p_SongName; }
 		float GetVol() const { return p_volume; }
@@ -45,14 +46,15 @@ class AudioPlayer {
 		void SetVol(float vol) { p_volume = vol; }
 
 		void InitDecoder(const Path &Pather, AudioDecoder &Decoder);
-		void InitDevice(AudioDecoder& Decoder, AudioDevice& Device, const ma_device_data_proc &Callback, AudioBuffering &Buffer);
-		void Switch(Path& Pather, AudioDecoder& Decoder, AudioDevice& Device, const ma_device_data_proc &Callback, Status& Timer, AudioBuffering& Buffer, SwitchAction SwitchCode);
+		void InitDevice(OutputSink& Device, const ma_device_data_proc &Callback, AudioBuffering &Buffer,
+						const LatencyProfile& Profile = GetLatencyProfile(LatencyMode::Balanced));
+		void Switch(Path& Pather, AudioDecoder& Decoder, OutputSink& Device, Status& Timer, AudioBuffering& Buffer, SwitchAction SwitchCode);
 
 		// This Function is using for switch the song, when the file is play done, or user switch manually
-		// void NextFileCheck(AudioBuffering& Buffer, Status& Timer, Path& Pather, AudioDecoder& Decoder, AudioDevice& Device, const ma_device_data_proc &Callback);
+		// void NextFileCheck(AudioBuffering& Buffer, Status& Timer, Path& Pather, AudioDecoder& Decoder, OutputSink& Device, const ma_device_data_proc &Callback);
 
-		void Clean(AudioBuffering& Buffer, Status& Timer, AudioDecoder& Decoder, AudioDevice& Device);
-		void Exit(AudioDevice &Device, AudioDecoder &Decoder);
+		void Clean(AudioBuffering& Buffer, Status& Timer, AudioDecoder& Decoder, OutputSink& Device);
+		void Exit(OutputSink &Device, AudioDecoder &Decoder);
 
 	private:
 		float p_volume;
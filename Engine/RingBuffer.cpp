@@ -0,0 +1,105 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: RingBuffer.cpp
+ *  Lib: Beeplayer Core engine Lock-free SPSC Ring Buffer
+ *  Author: Romi Brooks
+ *  Date: 2025-07-20
+ *  Type: Buffers, Core Engine
+ */
+
+#include "RingBuffer.hpp"
+
+// Standard Lib
+#include <algorithm>
+#include <cstring>
+
+void RingBuffer::Allocate(ma_uint64 CapacityFrames, ma_uint32 BytesPerFrame) {
+	ma_uint64 capacity = 1;
+	while (capacity < CapacityFrames) {
+		capacity <<= 1;
+	}
+
+	p_capacity = capacity;
+	p_mask = capacity - 1;
+	p_bytesPerFrame = BytesPerFrame;
+	p_data.assign(capacity * BytesPerFrame, 0);
+	Reset();
+}
+
+void RingBuffer::Reset() {
+	p_writeIndex.store(0, std::memory_order_relaxed);
+	p_readIndex.store(0, std::memory_order_relaxed);
+}
+
+ma_uint64 RingBuffer::AvailableWrite() const {
+	return p_capacity - (p_writeIndex.load(std::memory_order_relaxed) - p_readIndex.load(std::memory_order_acquire));
+}
+
+ma_uint64 RingBuffer::AvailableRead() const {
+	return p_writeIndex.load(std::memory_order_acquire) - p_readIndex.load(std::memory_order_relaxed);
+}
+
+ma_uint64 RingBuffer::Write(const void *Src, ma_uint64 Frames) {
+	const ma_uint64 write = p_writeIndex.load(std::memory_order_relaxed);
+	const ma_uint64 read = p_readIndex.load(std::memory_order_acquire);
+	const ma_uint64 frames = std::min(Frames, p_capacity - (write - read));
+
+	// Copy in at most two pieces: up to the end of the storage, then from the start
+	const ma_uint64 offset = write & p_mask;
+	const ma_uint64 first = std::min(frames, p_capacity - offset);
+	const auto* src = static_cast<const ma_uint8*>(Src);
+	memcpy(p_data.data() + offset * p_bytesPerFrame, src, first * p_bytesPerFrame);
+	memcpy(p_data.data(), src + first * p_bytesPerFrame, (frames - first) * p_bytesPerFrame);
+
+	p_writeIndex.store(write + frames, std::memory_order_release);
+	return frames;
+}
+
+ma_uint64 RingBuffer::Read(void *Dst, ma_uint64 Frames) {
+	const ma_uint64 read = p_readIndex.load(std::memory_order_relaxed);
+	const ma_uint64 write = p_writeIndex.load(std::memory_order_acquire);
+	const ma_uint64 frames = std::min(Frames, write - read);
+
+	const ma_uint64 offset = read & p_mask;
+	const ma_uint64 first = std::min(frames, p_capacity - offset);
+	auto* dst = static_cast<ma_uint8*>(Dst);
+	memcpy(dst, p_data.data() + offset * p_bytesPerFrame, first * p_bytesPerFrame);
+	memcpy(dst + first * p_bytesPerFrame, p_data.data(), (frames - first) * p_bytesPerFrame);
+
+	p_readIndex.store(read + frames, std::memory_order_release);
+	return frames;
+}
+
+RingBuffer::WriteRegion RingBuffer::AcquireWrite(ma_uint64 MaxFrames) {
+	const ma_uint64 write = p_writeIndex.load(std::memory_order_relaxed);
+	const ma_uint64 read = p_readIndex.load(std::memory_order_acquire);
+	const ma_uint64 offset = write & p_mask;
+	const ma_uint64 frames = std::min({MaxFrames, p_capacity - (write - read), p_capacity - offset});
+	return {p_data.data() + offset * p_bytesPerFrame, frames};
+}
+
+void RingBuffer::CommitWrite(ma_uint64 Frames) {
+	p_writeIndex.store(p_writeIndex.load(std::memory_order_relaxed) + Frames, std::memory_order_release);
+}
+
+RingBuffer::ReadRegion RingBuffer::AcquireRead(ma_uint64 MaxFrames) {
+	const ma_uint64 read = p_readIndex.load(std::memory_order_relaxed);
+	const ma_uint64 write = p_writeIndex.load(std::memory_order_acquire);
+	const ma_uint64 offset = read & p_mask;
+	const ma_uint64 frames = std::min({MaxFrames, write - read, p_capacity - offset});
+	return {p_data.data() + offset * p_bytesPerFrame, frames};
+}
+
+void RingBuffer::CommitRead(ma_uint64 Frames) {
+	p_readIndex.store(p_readIndex.load(std::memory_order_relaxed) + Frames, std::memory_order_release);
+}
+
+void RingBuffer::Discard() {
+	p_readIndex.store(p_writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void RingBuffer::DiscardTo(ma_uint64 Index) {
+	const ma_uint64 read = p_readIndex.load(std::memory_order_relaxed);
+	if (Index > read) {
+		p_readIndex.store(Index, std::memory_order_release);
+	}
+}
@@ -0,0 +1,82 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: RingBuffer.hpp
+ *  Lib: Beeplayer Core engine Lock-free SPSC Ring Buffer definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-07-20
+ *  Type: Buffers, Core Engine
+ */
+
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+// Standard Lib
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+
+// Single-producer / single-consumer ring of PCM frames.
+// The filler thread is the only writer and data_callback is the only reader, so the two
+// indices need nothing more than acquire/release ordering. Indices are monotonic frame
+// counters (they never wrap in practice), the slot is (index & mask).
+// Each index lives on its own cache line so producer and consumer never false-share.
+
+class RingBuffer {
+	public:
+		static constexpr size_t CacheLineSize = 64;
+
+		// A contiguous run of slots inside the storage. Regions never wrap: near the end of the
+		// storage they come back shorter, and the next Acquire starts again at slot 0.
+		struct WriteRegion {
+			void* s_data = nullptr;
+			ma_uint64 s_frames = 0;
+		};
+		struct ReadRegion {
+			const void* s_data = nullptr;
+			ma_uint64 s_frames = 0;
+		};
+
+		RingBuffer() = default;
+
+		RingBuffer(const RingBuffer&) = delete;
+		RingBuffer& operator=(const RingBuffer&) = delete;
+
+		// Not thread safe: call only while neither side is running.
+		// The capacity is rounded up to the next power of two frames.
+		void Allocate(ma_uint64 CapacityFrames, ma_uint32 BytesPerFrame);
+		void Reset();
+
+		// Producer side
+		ma_uint64 Write(const void* Src, ma_uint64 Frames);
+		ma_uint64 AvailableWrite() const;
+		// Zero-copy: fill the region in place (e.g. decode straight into it), then publish what was written
+		WriteRegion AcquireWrite(ma_uint64 MaxFrames);
+		void CommitWrite(ma_uint64 Frames);
+
+		// Consumer side
+		ma_uint64 Read(void* Dst, ma_uint64 Frames);
+		ma_uint64 AvailableRead() const;
+		ReadRegion AcquireRead(ma_uint64 MaxFrames);
+		void CommitRead(ma_uint64 Frames);
+		void Discard(); // drop everything the producer has published so far
+		void DiscardTo(ma_uint64 Index); // drop frames before a write index the producer handed us
+
+		// Getter
+		ma_uint64 GetCapacity() const { return p_capacity; }
+		ma_uint64 GetWriteIndex() const { return p_writeIndex.load(std::memory_order_acquire); }
+		ma_uint64 GetReadIndex() const { return p_readIndex.load(std::memory_order_acquire); }
+		ma_uint32 GetBytesPerFrame() const { return p_bytesPerFrame; }
+
+	private:
+		std::vector<ma_uint8> p_data;
+		ma_uint64 p_capacity = 0;   // Frames, power of two
+		ma_uint64 p_mask = 0;       // p_capacity - 1
+		ma_uint32 p_bytesPerFrame = 0;
+
+		alignas(CacheLineSize) std::atomic<ma_uint64> p_writeIndex{0}; // Owned by the producer
+		alignas(CacheLineSize) std::atomic<ma_uint64> p_readIndex{0};  // Owned by the consumer
+};
+
+#endif //RINGBUFFER_HPP
@@ -0,0 +1,237 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: SeekIndex.cpp
+ *  Lib: Beeplayer Core engine MP3 Seek Index
+ *  Author: Romi Brooks
+ *  Date: 2025-07-22
+ *  Type: Decoder, Core Engine
+ */
+
+#include "SeekIndex.hpp"
+
+// Standard Lib
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+	#include <process.h>
+#else
+	#include <unistd.h>
+#endif
+
+// Basic Lib
+#include "../FileSystem/Encoding.hpp"
+#include "../FileSystem/Path.hpp"
+#include "../Log/LogSystem.hpp"
+
+namespace {
+	constexpr char CacheMagic[4] = {'B', 'P', 'S', 'K'};
+	constexpr ma_uint32 CacheVersion = 1;
+	constexpr ma_uint64 HashSampleBytes = 64 * 1024;
+
+	// FNV-1a, enough to tell files apart for a cache key
+	ma_uint64 Fnv1a(ma_uint64 Hash, const char* Data, size_t Size) {
+		for (size_t i = 0; i < Size; ++i) {
+			Hash ^= static_cast<unsigned char>(Data[i]);
+			Hash *= 1099511628211ULL;
+		}
+		return Hash;
+	}
+
+	// The playlist stores UTF-8, Windows wants wide paths for anything non-ASCII
+	fs::path NativePath(const std::string& U8Path) {
+#ifdef _WIN32
+		return fs::path(Encoding::u8tou16(U8Path));
+#else
+		return fs::path(U8Path);
+#endif
+	}
+
+	unsigned long ProcessId() {
+#ifdef _WIN32
+		return static_cast<unsigned long>(_getpid());
+#else
+		return static_cast<unsigned long>(getpid());
+#endif
+	}
+
+	// Indexes somebody still holds, by file path. Expired entries are swept when a new one is added.
+	std::mutex IndexesLock;
+	std::unordered_map<std::string, std::weak_ptr<SeekIndex>> Indexes;
+}
+
+std::shared_ptr<SeekIndex> SeekIndex::ForFile(const std::string& FilePath) {
+	std::lock_guard lock(IndexesLock);
+	if (auto existing = Indexes[FilePath].lock()) {
+		return existing;
+	}
+	std::erase_if(Indexes, [](const auto& entry) { return entry.second.expired(); });
+	auto index = std::make_shared<SeekIndex>(FilePath);
+	Indexes[FilePath] = index;
+	return index;
+}
+
+DecodeService::Job SeekIndex::BuildAsync(const std::shared_ptr<SeekIndex>& Index, DecodePriority Priority) {
+	if (Index->p_queued.exchange(true, std::memory_order_acq_rel)) {
+		return {};
+	}
+	return DecodeService::GetInstance().Submit(Priority, [Index](const std::atomic<bool>&) { Index->Build(); });
+}
+
+void SeekIndex::Build() {
+	const ma_uint64 hash = ContentHash();
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bsk", static_cast<unsigned long long>(hash));
+	const std::string cacheFile = (Path::CacheDirectory() / "seek" / name).string();
+
+	if (LoadCache(cacheFile, hash)) {
+		Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DECODER, "Seek index loaded from cache: ", p_points.size(), " points.");
+	} else if (Scan()) {
+		SaveCache(cacheFile, hash);
+		Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_DECODER, "Seek index built: ", p_points.size(), " points.");
+	} else {
+		Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_DECODER, "Failed to build seek index for: ", Path::GetFileName(p_filePath));
+		return;
+	}
+
+	p_ready.store(true, std::memory_order_release);
+}
+
+ma_result SeekIndex::Seek(ma_decoder *pDecoder, ma_uint64 FrameIndex) {
+	if (!IsReady() || p_points.empty()) {
+		return ma_decoder_seek_to_pcm_frame(pDecoder, FrameIndex);
+	}
+
+	// The points are in the file's own sample rate, the target is in the output rate
+	ma_uint32 internalRate = 0;
+	ma_data_source_get_data_format(pDecoder->pBackend, nullptr, nullptr, &internalRate, nullptr, 0);
+	const ma_uint64 internalFrame = (internalRate == 0 || internalRate == pDecoder->outputSampleRate)
+										? FrameIndex
+										: FrameIndex * internalRate / pDecoder->outputSampleRate;
+
+	// Binary search for the last point at or before the target, and hand dr_mp3 just that one
+	const auto it = std::upper_bound(p_points.begin(), p_points.end(), internalFrame,
+									 [](ma_uint64 frame, const ma_dr_mp3_seek_point& point) { return frame < point.pcmFrameIndex; });
+	if (it != p_points.begin()) {
+		p_bound = *(it - 1);
+		auto* mp3 = static_cast<ma_mp3*>(pDecoder->pBackend);
+		ma_dr_mp3_bind_seek_table(&mp3->dr, 1, &p_bound);
+	}
+
+	return ma_decoder_seek_to_pcm_frame(pDecoder, FrameIndex);
+}
+
+bool SeekIndex::Scan() {
+	ma_dr_mp3 mp3;
+	ma_bool32 opened;
+#ifdef _WIN32
+	opened = Encoding::IsPureAscii(p_filePath) ? ma_dr_mp3_init_file(&mp3, p_filePath.c_str(), nullptr)
+											   : ma_dr_mp3_init_file_w(&mp3, Encoding::u8tou16(p_filePath).c_str(), nullptr);
+#else
+	opened = ma_dr_mp3_init_file(&mp3, p_filePath.c_str(), nullptr);
+#endif
+	if (!opened) {
+		return false;
+	}
+
+	std::error_code ec;
+	const ma_uint64 fileSize = fs::file_size(NativePath(p_filePath), ec);
+	auto count = static_cast<ma_uint32>(std::clamp<ma_uint64>(ec ? 0 : fileSize / BytesPerPoint, 16, MaxPoints));
+
+	std::vector<ma_dr_mp3_seek_point> points(count);
+	const bool built = ma_dr_mp3_calculate_seek_points(&mp3, &count, points.data());
+	ma_dr_mp3_uninit(&mp3);
+	if (!built) {
+		return false;
+	}
+
+	points.resize(count);
+	p_points = std::move(points);
+	return true;
+}
+
+bool SeekIndex::LoadCache(const std::string& CacheFile, ma_uint64 Hash) {
+	std::ifstream in(CacheFile, std::ios::binary);
+	if (!in) {
+		return false;
+	}
+
+	char magic[4];
+	ma_uint32 version = 0, count = 0;
+	ma_uint64 hash = 0;
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(&version), sizeof(version));
+	in.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+	in.read(reinterpret_cast<char*>(&count), sizeof(count));
+	if (!in || !std::equal(magic, magic + 4, CacheMagic) || version != CacheVersion || hash != Hash || count > MaxPoints) {
+		return false;
+	}
+
+	std::vector<ma_dr_mp3_seek_point> points(count);
+	for (auto& point : points) {
+		in.read(reinterpret_cast<char*>(&point.seekPosInBytes), sizeof(point.seekPosInBytes));
+		in.read(reinterpret_cast<char*>(&point.pcmFrameIndex), sizeof(point.pcmFrameIndex));
+		in.read(reinterpret_cast<char*>(&point.mp3FramesToDiscard), sizeof(point.mp3FramesToDiscard));
+		in.read(reinterpret_cast<char*>(&point.pcmFramesToDiscard), sizeof(point.pcmFramesToDiscard));
+	}
+	if (!in) {
+		return false;
+	}
+
+	p_points = std::move(points);
+	return true;
+}
+
+void SeekIndex::SaveCache(const std::string& CacheFile, ma_uint64 Hash) const {
+	std::error_code ec;
+	fs::create_directories(fs::path(CacheFile).parent_path(), ec);
+
+	// Write to a temporary name first so a crash never leaves a half-written table behind. The name is
+	// per process and thread: another player (or build) writing the same table must not share it.
+	const std::string temp = CacheFile + "." + std::to_string(ProcessId()) + "-"
+							 + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+		const auto count = static_cast<ma_uint32>(p_points.size());
+		out.write(CacheMagic, sizeof(CacheMagic));
+		out.write(reinterpret_cast<const char*>(&CacheVersion), sizeof(CacheVersion));
+		out.write(reinterpret_cast<const char*>(&Hash), sizeof(Hash));
+		out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		for (const auto& point : p_points) {
+			out.write(reinterpret_cast<const char*>(&point.seekPosInBytes), sizeof(point.seekPosInBytes));
+			out.write(reinterpret_cast<const char*>(&point.pcmFrameIndex), sizeof(point.pcmFrameIndex));
+			out.write(reinterpret_cast<const char*>(&point.mp3FramesToDiscard), sizeof(point.mp3FramesToDiscard));
+			out.write(reinterpret_cast<const char*>(&point.pcmFramesToDiscard), sizeof(point.pcmFramesToDiscard));
+		}
+		if (!out) {
+			return;
+		}
+	}
+	fs::rename(temp, CacheFile, ec);
+}
+
+ma_uint64 SeekIndex::ContentHash() const {
+	// Size plus the first and last 64 KiB: cheap on huge files, and tags/edits change it
+	const fs::path file = NativePath(p_filePath);
+	std::ifstream in(file, std::ios::binary);
+	std::error_code ec;
+	const ma_uint64 size = fs::file_size(file, ec);
+
+	ma_uint64 hash = Fnv1a(14695981039346656037ULL, reinterpret_cast<const char*>(&size), sizeof(size));
+	std::vector<char> block(HashSampleBytes);
+
+	in.read(block.data(), static_cast<std::streamsize>(block.size()));
+	hash = Fnv1a(hash, block.data(), static_cast<size_t>(in.gcount()));
+
+	if (size > HashSampleBytes) {
+		in.clear();
+		in.seekg(static_cast<std::streamoff>(size - HashSampleBytes));
+		in.read(block.data(), static_cast<std::streamsize>(block.size()));
+		hash = Fnv1a(hash, block.data(), static_cast<size_t>(in.gcount()));
+	}
+	return hash;
+}
@@ -0,0 +1,65 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: SeekIndex.hpp
+ *  Lib: Beeplayer Core engine MP3 Seek Index definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-07-22
+ *  Type: Decoder, Core Engine
+ */
+
+#ifndef SEEKINDEX_HPP
+#define SEEKINDEX_HPP
+
+// Standard Lib
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+#include "DecodeService.hpp"
+
+// MP3 has no random access, so without help every seek rescans frames from the start of the file
+// (painful on 2-hour mixes). A SeekIndex is a table of (byte offset, PCM frame) points built once
+// per file in the background, cached on disk under a content hash, and used to jump straight to the
+// closest point before a target: a binary search plus one short decode.
+
+class SeekIndex {
+	public:
+		static constexpr ma_uint64 BytesPerPoint = 16 * 1024; // Roughly one point every ~40 MP3 frames
+		static constexpr ma_uint32 MaxPoints = 1 << 16;
+
+		explicit SeekIndex(std::string FilePath) : p_filePath(std::move(FilePath)) {}
+
+		// The index of a file, shared while anyone holds it: a decoder opening a file the read-ahead is
+		// still indexing gets that index instead of scanning the file a second time
+		static std::shared_ptr<SeekIndex> ForFile(const std::string& FilePath);
+
+		// Queue the build on the decode service, once per index (an invalid job when it was queued
+		// before). The job keeps the index alive until it ends, so the owning decoder may go away first.
+		static DecodeService::Job BuildAsync(const std::shared_ptr<SeekIndex>& Index,
+											 DecodePriority Priority = DecodePriority::Background);
+
+		// Blocking: load from the cache, or scan the file and store the result
+		void Build();
+
+		bool IsReady() const { return p_ready.load(std::memory_order_acquire); }
+		size_t GetPointCount() const { return IsReady() ? p_points.size() : 0; }
+
+		// Filler thread only (it owns the decoder). Falls back to a plain seek until the index is ready.
+		ma_result Seek(ma_decoder* pDecoder, ma_uint64 FrameIndex);
+
+	private:
+		std::string p_filePath;
+		std::vector<ma_dr_mp3_seek_point> p_points; // Sorted by pcmFrameIndex (internal sample rate)
+		std::atomic<bool> p_ready{false};
+		std::atomic<bool> p_queued{false};          // BuildAsync() ran for this index
+		ma_dr_mp3_seek_point p_bound{};             // The single point currently bound to the decoder
+
+		bool Scan();
+		bool LoadCache(const std::string& CacheFile, ma_uint64 Hash);
+		void SaveCache(const std::string& CacheFile, ma_uint64 Hash) const;
+		ma_uint64 ContentHash() const;
+};
+
+#endif //SEEKINDEX_HPP
@@ -0,0 +1,77 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: Seqlock.hpp
+ *  Lib: Beeplayer Core engine Seqlock State Publication definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-08-01
+ *  Type: Sync, Core Engine
+ */
+
+#ifndef SEQLOCK_HPP
+#define SEQLOCK_HPP
+
+// Standard Lib
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+// Basic Lib
+#include "../miniaudio/miniaudio.h"
+
+// One writer publishes a small trivially copyable struct, any number of readers take consistent
+// copies without locks. Same scheme as the seek flush in AudioBuffering: an odd sequence means a
+// write is in progress and readers retry. The payload is kept in atomic words so no read is a data race.
+template <typename T>
+class Seqlock {
+	static_assert(std::is_trivially_copyable_v<T>, "Seqlock payload must be trivially copyable");
+
+	public:
+		Seqlock() { Store(T{}); }
+
+		Seqlock(const Seqlock&) = delete;
+		Seqlock& operator=(const Seqlock&) = delete;
+
+		// Writer only
+		void Store(const T& Value) {
+			ma_uint64 words[Words] = {};
+			memcpy(words, &Value, sizeof(T));
+
+			const ma_uint32 sequence = p_sequence.load(std::memory_order_relaxed);
+			p_sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			for (size_t i = 0; i < Words; ++i) {
+				p_words[i].store(words[i], std::memory_order_relaxed);
+			}
+			p_sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+		// Any thread, retries only while a Store() is running (a handful of stores long)
+		T Load() const {
+			ma_uint64 words[Words];
+			for (;;) {
+				const ma_uint32 sequence = p_sequence.load(std::memory_order_acquire);
+				if (sequence & 1) {
+					continue;
+				}
+				for (size_t i = 0; i < Words; ++i) {
+					words[i] = p_words[i].load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (p_sequence.load(std::memory_order_relaxed) == sequence) {
+					break;
+				}
+			}
+
+			T value;
+			memcpy(&value, words, sizeof(T));
+			return value;
+		}
+
+	private:
+		static constexpr size_t Words = (sizeof(T) + sizeof(ma_uint64) - 1) / sizeof(ma_uint64);
+
+		std::atomic<ma_uint32> p_sequence{0};
+		std::atomic<ma_uint64> p_words[Words];
+};
+
+#endif //SEQLOCK_HPP
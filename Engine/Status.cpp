@@ -16,9 +16,7 @@ Status::Status(AudioDecoder &Decoder) {
 }
 
 void Status::SetFileLength(AudioDecoder &Decoder) {
-	ma_uint64 temp_fileTotalFrames = 0;
-	ma_data_source_get_length_in_pcm_frames(&Decoder.GetDecoder(), &temp_fileTotalFrames); // get the file's total frame
-	p_fileTotalFrames.store(temp_fileTotalFrames); // Store the file's total frames
+	p_fileTotalFrames.store(Decoder.GetLengthInFrames()); // Store the file's total frames (measured once by the decoder)
 }
 
 void Status::ResetStatus(){
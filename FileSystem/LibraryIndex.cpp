@@ -0,0 +1,443 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LibraryIndex.cpp
+ *  Lib: Beeplayer Persistent Library Index
+ *  Author: Romi Brooks
+ *  Date: 2025-08-09
+ *  Type: FileSystem
+ */
+#include "LibraryIndex.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Path.hpp"
+#include "../Log/LogSystem.hpp"
+
+namespace {
+	constexpr char IndexMagic[4] = {'B', 'P', 'L', 'I'};
+	constexpr std::uint32_t MaxCoverSize = 64 * 1024 * 1024;
+
+	std::uint32_t BigEndian32(const unsigned char* Bytes) {
+		return (std::uint32_t(Bytes[0]) << 24) | (std::uint32_t(Bytes[1]) << 16) | (std::uint32_t(Bytes[2]) << 8) | Bytes[3];
+	}
+
+	std::uint32_t LittleEndian32(const unsigned char* Bytes) {
+		return (std::uint32_t(Bytes[3]) << 24) | (std::uint32_t(Bytes[2]) << 16) | (std::uint32_t(Bytes[1]) << 8) | Bytes[0];
+	}
+
+	// ID3v2 sizes keep the high bit of every byte clear
+	std::uint32_t SyncSafe32(const unsigned char* Bytes) {
+		return (std::uint32_t(Bytes[0] & 0x7f) << 21) | (std::uint32_t(Bytes[1] & 0x7f) << 14) |
+			   (std::uint32_t(Bytes[2] & 0x7f) << 7) | (Bytes[3] & 0x7f);
+	}
+
+	bool ReadAt(std::ifstream& In, std::uint64_t Offset, unsigned char* Bytes, size_t Count) {
+		In.clear();
+		In.seekg(static_cast<std::streamoff>(Offset));
+		In.read(reinterpret_cast<char*>(Bytes), static_cast<std::streamsize>(Count));
+		return static_cast<size_t>(In.gcount()) == Count;
+	}
+
+	// Where the ID3v2 tag starts: the head of an MP3, the "id3 " chunk of a WAV
+	bool FindId3Tag(std::ifstream& In, bool Wav, std::uint64_t& Offset) {
+		if (!Wav) {
+			Offset = 0;
+			return true;
+		}
+		unsigned char riff[12];
+		if (!ReadAt(In, 0, riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+			return false;
+		}
+		const std::uint64_t end = std::uint64_t(LittleEndian32(riff + 4)) + 8;
+		std::uint64_t position = sizeof(riff);
+		unsigned char chunk[8];
+		while (position + sizeof(chunk) <= end && ReadAt(In, position, chunk, sizeof(chunk))) {
+			const std::uint32_t size = LittleEndian32(chunk + 4);
+			if (std::memcmp(chunk, "id3 ", 4) == 0 || std::memcmp(chunk, "ID3 ", 4) == 0) {
+				Offset = position + sizeof(chunk);
+				return true;
+			}
+			position += sizeof(chunk) + size + (size & 1); // Chunks are word aligned
+		}
+		return false;
+	}
+}
+
+LibraryIndex::LibraryIndex(fs::path Root)
+	: p_root(std::move(Root)), p_file(Path::LibraryCacheFile(p_root, "bli")) {}
+
+LibraryIndex::~LibraryIndex() {
+	Unmap();
+}
+
+bool LibraryIndex::Open() {
+	std::lock_guard lock(p_lock);
+	Unmap();
+	return Map();
+}
+
+bool LibraryIndex::Map() {
+#ifdef _WIN32
+	HANDLE file = CreateFileW(p_file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+							  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size{};
+	HANDLE mapping = nullptr;
+	const void* view = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart >= static_cast<LONGLONG>(sizeof(Header))) {
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+	if (!view) {
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	p_handle = file;
+	p_mapping = mapping;
+	p_data = static_cast<const char*>(view);
+	p_size = static_cast<size_t>(size.QuadPart);
+#else
+	const int file = ::open(p_file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (file < 0) {
+		return false;
+	}
+	struct stat status{};
+	void* view = MAP_FAILED;
+	if (fstat(file, &status) == 0 && status.st_size >= static_cast<off_t>(sizeof(Header))) {
+		view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	::close(file); // The mapping keeps the file
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	p_data = static_cast<const char*>(view);
+	p_size = static_cast<size_t>(status.st_size);
+#endif
+
+	// Everything the records point at has to be inside the file
+	Header header;
+	std::memcpy(&header, p_data, sizeof(header));
+	const std::uint64_t recordsEnd = sizeof(Header) + std::uint64_t(header.s_count) * sizeof(Record);
+	if (!std::equal(header.s_magic, header.s_magic + 4, IndexMagic) || header.s_version != Version ||
+		recordsEnd > header.s_stringsOffset || header.s_stringsOffset > p_size ||
+		header.s_stringsSize > p_size - header.s_stringsOffset) {
+		Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_PATH, "Ignoring unreadable library index: ", p_file.string());
+		Unmap();
+		return false;
+	}
+	return true;
+}
+
+void LibraryIndex::Unmap() {
+	if (!p_data) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(p_data);
+	CloseHandle(static_cast<HANDLE>(p_mapping));
+	CloseHandle(static_cast<HANDLE>(p_handle));
+	p_handle = p_mapping = nullptr;
+#else
+	munmap(const_cast<char*>(p_data), p_size);
+#endif
+	p_data = nullptr;
+	p_size = 0;
+}
+
+size_t LibraryIndex::Count() const {
+	if (!p_data) {
+		return 0;
+	}
+	return reinterpret_cast<const Header*>(p_data)->s_count;
+}
+
+const LibraryIndex::Record* LibraryIndex::Records() const {
+	return reinterpret_cast<const Record*>(p_data + sizeof(Header));
+}
+
+std::string_view LibraryIndex::String(std::uint32_t Offset, std::uint32_t Length) const {
+	const auto* header = reinterpret_cast<const Header*>(p_data);
+	if (std::uint64_t(Offset) + Length > header->s_stringsSize) {
+		return {};
+	}
+	return {p_data + header->s_stringsOffset + Offset, Length};
+}
+
+const LibraryIndex::Record* LibraryIndex::Find(std::string_view Relative) const {
+	const Record* begin = Records();
+	const Record* end = begin + Count();
+	const Record* found = std::lower_bound(begin, end, Relative, [this](const Record& Entry, std::string_view Key) {
+		return String(Entry.s_pathOffset, Entry.s_pathLength) < Key;
+	});
+	if (found == end || String(found->s_pathOffset, found->s_pathLength) != Relative) {
+		return nullptr;
+	}
+	return found;
+}
+
+TrackInfo LibraryIndex::ToInfo(const Record& Entry) const {
+	TrackInfo info;
+	info.s_size = Entry.s_size;
+	info.s_mtime = Entry.s_mtime;
+	info.s_hasTags = (Entry.s_flags & RecordHasTags) != 0;
+	info.s_durationMs = Entry.s_durationMs;
+	info.s_sampleRate = Entry.s_sampleRate;
+	info.s_channels = Entry.s_channels;
+	info.s_title = String(Entry.s_titleOffset, Entry.s_titleLength);
+	info.s_artist = String(Entry.s_artistOffset, Entry.s_artistLength);
+	info.s_coverOffset = Entry.s_coverOffset;
+	info.s_coverSize = Entry.s_coverSize;
+	return info;
+}
+
+void LibraryIndex::ForEachPath(const std::function<void(std::string_view Relative)>& Visit) const {
+	std::lock_guard lock(p_lock);
+	if (!p_data) {
+		return;
+	}
+	const Record* records = Records();
+	for (size_t i = 0; i < Count(); ++i) {
+		Visit(String(records[i].s_pathOffset, records[i].s_pathLength));
+	}
+}
+
+bool LibraryIndex::Lookup(const std::string& Relative, TrackInfo& Info) {
+	const fs::path file = p_root / fs::path(Relative);
+	std::error_code ec;
+	const std::uint64_t size = fs::file_size(file, ec);
+	if (ec) {
+		return false;
+	}
+	const std::int64_t mtime = fs::last_write_time(file, ec).time_since_epoch().count();
+	if (ec) {
+		return false;
+	}
+
+	{
+		std::lock_guard lock(p_lock);
+		const auto fresh = p_fresh.find(Relative);
+		if (fresh != p_fresh.end() && fresh->second.s_size == size && fresh->second.s_mtime == mtime) {
+			Info = fresh->second;
+			return Info.s_hasTags;
+		}
+		const Record* entry = p_data ? Find(Relative) : nullptr;
+		if (entry && (entry->s_flags & RecordHasTags) && entry->s_size == size && entry->s_mtime == mtime) {
+			Info = ToInfo(*entry);
+			return true;
+		}
+	}
+
+	// New or changed: parse outside the lock, other threads may be looking up other tracks meanwhile
+	TrackInfo info;
+	info.s_size = size;
+	info.s_mtime = mtime;
+	ReadTrack(file, info);
+
+	std::lock_guard lock(p_lock);
+	Info = p_fresh.insert_or_assign(Relative, std::move(info)).first->second;
+	return Info.s_hasTags;
+}
+
+bool LibraryIndex::ReadTrack(const fs::path& File, TrackInfo& Info) const {
+	auto& reader = AudioMetadataReader::getInstance();
+#ifdef _WIN32
+	if (!reader.getTrackInfo(File.wstring(), Info)) {
+#else
+	if (!reader.getTrackInfo(File.string(), Info)) {
+#endif
+		Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_METADATA, "Could not read tags: ", File.string());
+		return false;
+	}
+	LocateCover(File, Info);
+	return true;
+}
+
+bool LibraryIndex::HasChanges() const {
+	std::lock_guard lock(p_lock);
+	return !p_fresh.empty();
+}
+
+bool LibraryIndex::Save(const TrackStore& Tracks) {
+	const auto start = std::chrono::steady_clock::now();
+	std::lock_guard lock(p_lock);
+
+	std::vector<Record> records;
+	records.reserve(Tracks.Size());
+	std::string strings;
+	const auto append = [&strings](std::string_view Text, std::uint32_t& Offset, std::uint32_t& Length) {
+		Offset = static_cast<std::uint32_t>(strings.size());
+		Length = static_cast<std::uint32_t>(Text.size());
+		strings.append(Text);
+	};
+
+	std::string relative;
+	for (size_t i = 0; i < Tracks.Size(); ++i) {
+		relative.clear();
+		Tracks.AppendPath(i, relative);
+		Record record{};
+		append(relative, record.s_pathOffset, record.s_pathLength);
+
+		TrackInfo info;
+		const auto fresh = p_fresh.find(relative);
+		if (fresh != p_fresh.end()) {
+			info = fresh->second;
+		} else if (const Record* old = p_data ? Find(relative) : nullptr) {
+			info = ToInfo(*old);
+		}
+		if (info.s_hasTags) {
+			record.s_size = info.s_size;
+			record.s_mtime = info.s_mtime;
+			record.s_coverOffset = info.s_coverOffset;
+			record.s_coverSize = info.s_coverSize;
+			record.s_durationMs = info.s_durationMs;
+			record.s_sampleRate = info.s_sampleRate;
+			record.s_channels = info.s_channels;
+			record.s_flags = RecordHasTags;
+			append(info.s_title, record.s_titleOffset, record.s_titleLength);
+			append(info.s_artist, record.s_artistOffset, record.s_artistLength);
+		}
+		records.push_back(record);
+	}
+	if (strings.size() > std::numeric_limits<std::uint32_t>::max()) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_PATH, "Library too large for the index: ", Tracks.Size(), " tracks");
+		return false;
+	}
+
+	Header header{};
+	std::copy(IndexMagic, IndexMagic + 4, header.s_magic);
+	header.s_version = Version;
+	header.s_count = static_cast<std::uint32_t>(records.size());
+	header.s_stringsOffset = sizeof(Header) + records.size() * sizeof(Record);
+	header.s_stringsSize = strings.size();
+
+	std::error_code ec;
+	fs::create_directories(p_file.parent_path(), ec);
+	// Written aside and renamed over, a crash mid-write leaves the old index
+	const fs::path temporary = fs::path(p_file).concat(".tmp");
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)));
+		out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+		if (!out) {
+			Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_PATH, "Could not write the library index: ", temporary.string());
+			return false;
+		}
+	}
+
+	Unmap(); // Windows won't replace a mapped file
+	fs::rename(temporary, p_file, ec);
+	if (ec) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_PATH, "Could not replace the library index: ", ec.message());
+	} else {
+		p_fresh.clear();
+	}
+	const bool mapped = Map();
+
+	const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PATH, "Saved the library index: ", records.size(), " tracks in ", ms, " ms.");
+	return !ec && mapped;
+}
+
+std::vector<unsigned char> LibraryIndex::ReadCover(const fs::path& File, const TrackInfo& Info) {
+	std::vector<unsigned char> cover;
+	if (Info.s_coverSize == 0 || Info.s_coverSize > MaxCoverSize) {
+		return cover;
+	}
+	std::ifstream in(File, std::ios::binary);
+	cover.resize(Info.s_coverSize);
+	if (!in || !ReadAt(in, Info.s_coverOffset, cover.data(), cover.size())) {
+		cover.clear();
+	}
+	return cover;
+}
+
+bool LibraryIndex::LocateCover(const fs::path& File, TrackInfo& Info) {
+	Info.s_coverOffset = 0;
+	Info.s_coverSize = 0;
+
+	std::ifstream in(File, std::ios::binary);
+	std::string extension = File.extension().string();
+	std::ranges::transform(extension, extension.begin(), [](unsigned char c) { return std::tolower(c); });
+	std::uint64_t tag = 0;
+	if (!in || !FindId3Tag(in, extension == ".wav", tag)) {
+		return false;
+	}
+
+	// ID3v2.3 / 2.4 only. Unsynchronised, compressed or encrypted pictures are not stored as is in the
+	// file, those are left to TagLib (a cover size of 0).
+	unsigned char header[10];
+	if (!ReadAt(in, tag, header, sizeof(header)) || std::memcmp(header, "ID3", 3) != 0 ||
+		(header[3] != 3 && header[3] != 4) || (header[5] & 0x80)) {
+		return false;
+	}
+	const std::uint8_t version = header[3];
+	const std::uint64_t end = tag + sizeof(header) + SyncSafe32(header + 6);
+	std::uint64_t position = tag + sizeof(header);
+	if (header[5] & 0x40) {
+		unsigned char extended[4];
+		if (!ReadAt(in, position, extended, sizeof(extended))) {
+			return false;
+		}
+		position += version == 4 ? SyncSafe32(extended) : BigEndian32(extended) + 4;
+	}
+
+	unsigned char frame[10];
+	while (position + sizeof(frame) <= end && ReadAt(in, position, frame, sizeof(frame))) {
+		if (frame[0] == 0) {
+			break; // Padding
+		}
+		const std::uint32_t size = version == 4 ? SyncSafe32(frame + 4) : BigEndian32(frame + 4);
+		const std::uint64_t data = position + sizeof(frame);
+		if (std::memcmp(frame, "APIC", 4) != 0) {
+			position = data + size;
+			continue;
+		}
+		if ((version == 4 && (frame[9] & 0x4f)) || (version == 3 && (frame[9] & 0xe0))) {
+			return false;
+		}
+
+		// Text encoding, MIME type\0, picture type, description\0 (\0\0 in UTF-16), then the picture
+		unsigned char head[1024];
+		const size_t length = std::min<size_t>(size, sizeof(head));
+		if (!ReadAt(in, data, head, length) || length < 2) {
+			return false;
+		}
+		const bool wide = head[0] == 1 || head[0] == 2;
+		size_t i = 1;
+		while (i < length && head[i] != 0) ++i;
+		i += 2; // MIME terminator, picture type
+		if (wide) {
+			while (i + 1 < length && (head[i] != 0 || head[i + 1] != 0)) i += 2;
+			i += 2;
+		} else {
+			while (i < length && head[i] != 0) ++i;
+			i += 1;
+		}
+		if (i >= length || size - i > MaxCoverSize) {
+			return false;
+		}
+		Info.s_coverOffset = data + i;
+		Info.s_coverSize = static_cast<std::uint32_t>(size - i);
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,124 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LibraryIndex.hpp
+ *  Lib: Beeplayer Persistent Library Index definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-08-09
+ *  Type: FileSystem
+ */
+
+#ifndef LIBRARYINDEX_HPP
+#define LIBRARYINDEX_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Metadata.hpp"
+#include "TrackStore.hpp"
+
+namespace fs = std::filesystem;
+
+// The library as it was last seen, in one file per root (Path::LibraryCacheFile(root, "bli")) that is
+// memory mapped: a fixed size record per track, sorted by path, and a string table. Opening it costs a
+// map, so the track list is there at startup without walking the folders or parsing a single tag.
+//
+// Entries are checked lazily: Lookup() stats the file and only re-reads the tags (into memory) when its
+// size or mtime moved. Save() writes those back with the current track list.
+class LibraryIndex {
+	public:
+		static constexpr std::uint32_t Version = 1;
+
+		explicit LibraryIndex(fs::path Root);
+		~LibraryIndex();
+
+		LibraryIndex(const LibraryIndex&) = delete;
+		LibraryIndex& operator=(const LibraryIndex&) = delete;
+
+		// Map the index file, false when there is none (or it is not one we can read)
+		bool Open();
+		bool IsLoaded() const { return p_data != nullptr; }
+
+		// Relative paths (generic separators) of the indexed tracks, sorted like LibraryScanner::Scan().
+		// The views point into the mapping, they are only valid during the call.
+		void ForEachPath(const std::function<void(std::string_view Relative)>& Visit) const;
+
+		// Info of a track, re-read from the file when it changed since it was indexed. False: unreadable.
+		// Any thread.
+		bool Lookup(const std::string& Relative, TrackInfo& Info);
+
+		// Rewrite the index for Tracks. Known tracks keep what was read about them, new ones are read on
+		// their first Lookup().
+		bool Save(const TrackStore& Tracks);
+
+		// Something was read that the file does not have yet
+		bool HasChanges() const;
+
+		// Cover art bytes, read straight from the audio file at the offset the index keeps
+		static std::vector<unsigned char> ReadCover(const fs::path& File, const TrackInfo& Info);
+
+		// Find the first attached picture (ID3v2 APIC) in an MP3 or WAV file, fills s_coverOffset / s_coverSize
+		static bool LocateCover(const fs::path& File, TrackInfo& Info);
+
+	private:
+		struct Header {
+			char s_magic[4];
+			std::uint32_t s_version;
+			std::uint32_t s_count;
+			std::uint32_t s_reserved;
+			std::uint64_t s_stringsOffset; // String table, the records follow the header
+			std::uint64_t s_stringsSize;
+		};
+
+		struct Record {
+			std::uint64_t s_size;
+			std::int64_t s_mtime;
+			std::uint64_t s_coverOffset;
+			std::uint32_t s_pathOffset;   // Into the string table
+			std::uint32_t s_pathLength;
+			std::uint32_t s_titleOffset;
+			std::uint32_t s_titleLength;
+			std::uint32_t s_artistOffset;
+			std::uint32_t s_artistLength;
+			std::uint32_t s_coverSize;
+			std::uint32_t s_durationMs;
+			std::uint32_t s_sampleRate;
+			std::uint16_t s_channels;
+			std::uint16_t s_flags;        // RecordHasTags
+		};
+		static_assert(sizeof(Header) == 32 && sizeof(Record) == 64, "LibraryIndex: on-disk layout changed");
+		static constexpr std::uint16_t RecordHasTags = 1;
+
+		fs::path p_root;
+		fs::path p_file;
+
+		// Mapping of p_file, nullptr when not loaded
+		const char* p_data = nullptr;
+		size_t p_size = 0;
+#ifdef _WIN32
+		void* p_handle = nullptr;
+		void* p_mapping = nullptr;
+#endif
+
+		// Read this session, not in the file yet
+		std::unordered_map<std::string, TrackInfo> p_fresh;
+		mutable std::mutex p_lock; // Guards the mapping and p_fresh
+
+		bool Map();
+		void Unmap();
+
+		size_t Count() const;
+		const Record* Records() const;
+		std::string_view String(std::uint32_t Offset, std::uint32_t Length) const;
+		const Record* Find(std::string_view Relative) const;
+		TrackInfo ToInfo(const Record& Entry) const;
+
+		// Stat and read the tags of a file
+		bool ReadTrack(const fs::path& File, TrackInfo& Info) const;
+};
+
+#endif //LIBRARYINDEX_HPP
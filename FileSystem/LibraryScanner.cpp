@@ -0,0 +1,296 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LibraryScanner.cpp
+ *  Lib: Beeplayer Parallel Incremental Library Scanner
+ *  Author: Romi Brooks
+ *  Date: 2025-08-06
+ *  Type: FileSystem
+ */
+#include "LibraryScanner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "Path.hpp"
+#include "../Log/LogSystem.hpp"
+
+namespace {
+	constexpr char CacheMagic[4] = {'B', 'P', 'L', 'S'};
+	constexpr std::uint32_t CacheVersion = 1;
+
+	void WriteString(std::ofstream& Out, const std::string& Text) {
+		const auto size = static_cast<std::uint32_t>(Text.size());
+		Out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		Out.write(Text.data(), size);
+	}
+
+	bool ReadString(std::ifstream& In, std::string& Text) {
+		std::uint32_t size = 0;
+		In.read(reinterpret_cast<char*>(&size), sizeof(size));
+		if (!In || size > 64 * 1024) {
+			return false;
+		}
+		Text.resize(size);
+		In.read(Text.data(), size);
+		return static_cast<bool>(In);
+	}
+
+	void WriteNames(std::ofstream& Out, const std::vector<std::string>& Names) {
+		const auto count = static_cast<std::uint32_t>(Names.size());
+		Out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		for (const auto& name : Names) {
+			WriteString(Out, name);
+		}
+	}
+
+	bool ReadNames(std::ifstream& In, std::vector<std::string>& Names) {
+		std::uint32_t count = 0;
+		In.read(reinterpret_cast<char*>(&count), sizeof(count));
+		if (!In || count > 16 * 1024 * 1024) {
+			return false;
+		}
+		Names.resize(count);
+		for (auto& name : Names) {
+			if (!ReadString(In, name)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string Child(const std::string& Folder, const std::string& Name) {
+		return Folder.empty() ? Name : Folder + '/' + Name;
+	}
+}
+
+LibraryScanner::LibraryScanner(fs::path Root, size_t Threads)
+	: p_root(std::move(Root)),
+	  p_threads(Threads != 0 ? Threads : std::clamp<size_t>(std::thread::hardware_concurrency() * 2, 4, 32)) {}
+
+bool LibraryScanner::IsMediaFile(const fs::path &File) {
+	std::string extension = File.extension().string();
+	std::ranges::transform(extension.begin(), extension.end(), extension.begin(),
+						   [](unsigned char c) { return std::tolower(c); });
+	return extension == ".mp3" || extension == ".wav";
+}
+
+std::vector<std::string> LibraryScanner::Scan(const BatchCallback& OnBatch) {
+	p_stats = {};
+	p_files.clear();
+	p_visited.clear();
+	p_listed.clear();
+	std::error_code ec;
+	if (!fs::is_directory(p_root, ec)) {
+		return {};
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	LoadCache();
+
+	p_queues = std::vector<WorkQueue>(p_threads);
+	PushFolder(0, "");
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < p_threads; ++i) {
+		workers.emplace_back(&LibraryScanner::Worker, this, i, std::cref(OnBatch));
+	}
+	Worker(0, OnBatch);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Workers finish in any order, sort so indices are the same on every scan
+	std::sort(p_files.begin(), p_files.end());
+	p_stats.s_directories = p_visited.size();
+	p_stats.s_files = p_files.size();
+	if (p_stats.s_listed > 0 || p_visited.size() != p_cache.size()) {
+		SaveCache();
+	}
+	p_cache.clear();
+
+	const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PATH, "Scanned ", p_stats.s_files, " files in ", p_stats.s_directories,
+				" folders (", p_stats.s_listed, " listed, the rest unchanged) in ", ms, " ms on ", p_threads, " threads.");
+	return std::move(p_files);
+}
+
+void LibraryScanner::Worker(size_t Self, const BatchCallback& OnBatch) {
+	std::vector<std::string> batch;
+	std::string folder;
+	for (;;) {
+		// Read before looking, a folder queued after the look then ends the wait at once
+		const std::uint32_t seen = p_work.load(std::memory_order_acquire);
+		if (TakeFolder(Self, folder)) {
+			Visit(Self, folder, batch, OnBatch);
+			if (p_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				// The last folder: nothing can be queued any more, let the idle workers finish
+				p_work.fetch_add(1, std::memory_order_release);
+				p_work.notify_all();
+			}
+			continue;
+		}
+		// Nothing to take or steal: done once no folder is queued or being listed anywhere
+		if (p_pending.load(std::memory_order_acquire) == 0) {
+			break;
+		}
+		// Others are still listing, sleep until they queue a sub folder or the walk ends
+		p_work.wait(seen, std::memory_order_acquire);
+	}
+	Flush(batch, OnBatch);
+}
+
+bool LibraryScanner::TakeFolder(size_t Self, std::string& Folder) {
+	{
+		WorkQueue& own = p_queues[Self];
+		std::lock_guard lock(own.s_lock);
+		if (own.s_folders.size() > own.s_front) {
+			Folder = std::move(own.s_folders.back());
+			own.s_folders.pop_back();
+			return true;
+		}
+	}
+	for (size_t i = 1; i < p_queues.size(); ++i) {
+		WorkQueue& victim = p_queues[(Self + i) % p_queues.size()];
+		std::lock_guard lock(victim.s_lock);
+		if (victim.s_folders.size() > victim.s_front) {
+			Folder = std::move(victim.s_folders[victim.s_front++]);
+			if (victim.s_front == victim.s_folders.size()) {
+				victim.s_folders.clear();
+				victim.s_front = 0;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void LibraryScanner::PushFolder(size_t Self, std::string Folder) {
+	p_pending.fetch_add(1, std::memory_order_acq_rel);
+	WorkQueue& own = p_queues[Self];
+	{
+		std::lock_guard lock(own.s_lock);
+		own.s_folders.push_back(std::move(Folder));
+	}
+	p_work.fetch_add(1, std::memory_order_release);
+	p_work.notify_one(); // One folder, one idle worker to steal it
+}
+
+void LibraryScanner::Visit(size_t Self, const std::string& Folder, std::vector<std::string>& Batch, const BatchCallback& OnBatch) {
+	const fs::path full = Folder.empty() ? p_root : p_root / fs::path(Folder);
+	std::error_code ec;
+	const std::int64_t mtime = fs::last_write_time(full, ec).time_since_epoch().count();
+	if (ec) {
+		return; // Skip Folder Error
+	}
+
+	Directory directory;
+	const auto cached = p_cache.find(Folder);
+	if (cached != p_cache.end() && cached->second.s_mtime == mtime) {
+		directory = cached->second;
+	} else {
+		directory.s_mtime = mtime;
+		for (fs::directory_iterator it(full, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+			try {
+				// Like the recursive iterator before: linked folders are not followed, linked files are
+				if (fs::is_directory(it->symlink_status())) {
+					directory.s_folders.push_back(it->path().filename().string());
+				} else if (it->is_regular_file() && IsMediaFile(it->path())) {
+					directory.s_files.push_back(it->path().filename().string());
+				}
+			} catch (...) {
+				// Skip File Error
+			}
+		}
+		std::lock_guard lock(p_visitedLock);
+		++p_stats.s_listed;
+		p_listed.emplace_back(Folder, mtime);
+	}
+
+	for (const auto& name : directory.s_folders) {
+		PushFolder(Self, Child(Folder, name));
+	}
+	for (const auto& name : directory.s_files) {
+		Batch.push_back(Child(Folder, name));
+		if (Batch.size() >= BatchSize) {
+			Flush(Batch, OnBatch);
+		}
+	}
+
+	std::lock_guard lock(p_visitedLock);
+	p_visited.emplace(Folder, std::move(directory));
+}
+
+void LibraryScanner::Flush(std::vector<std::string>& Batch, const BatchCallback& OnBatch) {
+	if (Batch.empty()) {
+		return;
+	}
+	std::lock_guard lock(p_filesLock);
+	if (OnBatch) {
+		OnBatch(Batch);
+	}
+	p_files.insert(p_files.end(), std::make_move_iterator(Batch.begin()), std::make_move_iterator(Batch.end()));
+	Batch.clear();
+}
+
+fs::path LibraryScanner::CacheFile() const {
+	return Path::LibraryCacheFile(p_root, "bls");
+}
+
+void LibraryScanner::LoadCache() {
+	p_cache.clear();
+	std::ifstream in(CacheFile(), std::ios::binary);
+	if (!in) {
+		return;
+	}
+
+	char magic[4];
+	std::uint32_t version = 0, count = 0;
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char*>(&version), sizeof(version));
+	in.read(reinterpret_cast<char*>(&count), sizeof(count));
+	if (!in || !std::equal(magic, magic + 4, CacheMagic) || version != CacheVersion) {
+		return;
+	}
+
+	for (std::uint32_t i = 0; i < count; ++i) {
+		std::string folder;
+		Directory directory;
+		if (!ReadString(in, folder)) {
+			break;
+		}
+		in.read(reinterpret_cast<char*>(&directory.s_mtime), sizeof(directory.s_mtime));
+		if (!in || !ReadNames(in, directory.s_files) || !ReadNames(in, directory.s_folders)) {
+			break; // A torn file only costs a full listing of what is missing
+		}
+		p_cache.emplace(std::move(folder), std::move(directory));
+	}
+}
+
+void LibraryScanner::SaveCache() const {
+	const fs::path file = CacheFile();
+	std::error_code ec;
+	fs::create_directories(file.parent_path(), ec);
+
+	// Written aside and renamed over, a crash mid-write leaves the old cache
+	const fs::path temporary = fs::path(file).concat(".tmp");
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			return;
+		}
+		const auto count = static_cast<std::uint32_t>(p_visited.size());
+		out.write(CacheMagic, sizeof(CacheMagic));
+		out.write(reinterpret_cast<const char*>(&CacheVersion), sizeof(CacheVersion));
+		out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		for (const auto& [folder, directory] : p_visited) {
+			WriteString(out, folder);
+			out.write(reinterpret_cast<const char*>(&directory.s_mtime), sizeof(directory.s_mtime));
+			WriteNames(out, directory.s_files);
+			WriteNames(out, directory.s_folders);
+		}
+		if (!out) {
+			return;
+		}
+	}
+	fs::rename(temporary, file, ec);
+}
@@ -0,0 +1,98 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LibraryScanner.hpp
+ *  Lib: Beeplayer Parallel Incremental Library Scanner definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-08-06
+ *  Type: FileSystem
+ */
+
+#ifndef LIBRARYSCANNER_HPP
+#define LIBRARYSCANNER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Finds the media files under a root. Directories are listed by a pool of workers that each keep their
+// own queue and steal from the others when it runs dry, so one deep folder does not serialize the walk
+// (on a NAS every listing is a round trip). Results are reported in batches while the walk goes on.
+//
+// A directory's mtime changes whenever an entry is added, removed or renamed in it, so each directory's
+// listing is cached with its mtime (in Path::CacheDirectory()). A rescan stats every directory but only
+// lists the ones that changed.
+class LibraryScanner {
+	public:
+		static constexpr size_t BatchSize = 512;
+		// Relative paths (generic separators) of media files, from any worker thread, one batch at a time
+		using BatchCallback = std::function<void(const std::vector<std::string>& Batch)>;
+
+		struct Stats {
+			size_t s_directories = 0; // Directories visited
+			size_t s_listed = 0;      // ... of which were actually listed (new or changed)
+			size_t s_files = 0;       // Media files found
+		};
+
+		// Threads 0: a pool sized for I/O bound work
+		explicit LibraryScanner(fs::path Root, size_t Threads = 0);
+
+		// Media files relative to the root, sorted. Blocks until the walk is done.
+		std::vector<std::string> Scan(const BatchCallback& OnBatch = nullptr);
+
+		const Stats& GetStats() const { return p_stats; }
+
+		// The folders the last Scan() had to list (new, or changed since the scan before) with the mtime they
+		// were listed at, in no particular order. Every other folder was there unchanged.
+		const std::vector<std::pair<std::string, std::int64_t>>& GetListedFolders() const { return p_listed; }
+
+		static bool IsMediaFile(const fs::path& File);
+
+	private:
+		struct Directory {
+			std::int64_t s_mtime = 0;
+			std::vector<std::string> s_files;   // Media file names
+			std::vector<std::string> s_folders; // Sub directory names
+		};
+
+		// One per worker. The owner pushes and pops at the back, thieves take from the front.
+		struct WorkQueue {
+			std::mutex s_lock;
+			std::vector<std::string> s_folders; // Relative paths, "" is the root
+			size_t s_front = 0;
+		};
+
+		fs::path p_root;
+		size_t p_threads;
+		Stats p_stats;
+
+		std::unordered_map<std::string, Directory> p_cache; // Read only while the walk runs
+		std::unordered_map<std::string, Directory> p_visited;
+		std::vector<std::pair<std::string, std::int64_t>> p_listed; // Under p_visitedLock while the walk runs
+		std::mutex p_visitedLock;
+
+		std::vector<WorkQueue> p_queues;
+		std::atomic<size_t> p_pending{0}; // Directories queued or being listed
+		std::atomic<std::uint32_t> p_work{0}; // Bumped when a folder is queued or the walk is done, idle workers wait on it
+
+		std::vector<std::string> p_files;
+		std::mutex p_filesLock;
+
+		void Worker(size_t Self, const BatchCallback& OnBatch);
+		bool TakeFolder(size_t Self, std::string& Folder);
+		void PushFolder(size_t Self, std::string Folder);
+		void Visit(size_t Self, const std::string& Folder, std::vector<std::string>& Batch, const BatchCallback& OnBatch);
+		void Flush(std::vector<std::string>& Batch, const BatchCallback& OnBatch);
+
+		fs::path CacheFile() const;
+		void LoadCache();
+		void SaveCache() const;
+};
+
+#endif //LIBRARYSCANNER_HPP
@@ -0,0 +1,325 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LibraryWatcher.cpp
+ *  Lib: Beeplayer Live Library Watcher
+ *  Author: Romi Brooks
+ *  Date: 2025-08-12
+ *  Type: FileSystem
+ */
+#include "LibraryWatcher.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "LibraryScanner.hpp"
+#include "../Log/LogSystem.hpp"
+
+namespace {
+#ifdef __linux__
+	constexpr std::uint32_t WatchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+										IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+#endif
+
+	std::string ChildPath(const std::string& Folder, const std::string& Name) {
+		return Folder.empty() ? Name : Folder + '/' + Name;
+	}
+
+	bool IsBelow(const std::string& Path, const std::string& Folder) {
+		return Folder.empty() || Path == Folder || (Path.size() > Folder.size() && Path.compare(0, Folder.size(), Folder) == 0 && Path[Folder.size()] == '/');
+	}
+}
+
+LibraryWatcher::LibraryWatcher(fs::path Root, ChangeCallback OnChange)
+	: p_root(std::move(Root)), p_onChange(std::move(OnChange)) {}
+
+LibraryWatcher::~LibraryWatcher() {
+	Stop();
+}
+
+bool LibraryWatcher::IsSupported() {
+#ifdef __linux__
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool LibraryWatcher::Start(bool Reconcile) {
+#ifdef __linux__
+	if (p_running) {
+		return true;
+	}
+	p_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	p_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (p_inotify < 0 || p_wake < 0) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_PATH, "Could not watch the library: ", std::strerror(errno));
+		Stop();
+		return false;
+	}
+	p_reconcile = Reconcile;
+	p_running = true;
+	p_thread = std::thread(&LibraryWatcher::Run, this);
+	return true;
+#else
+	(void)Reconcile;
+	Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_PATH, "Library watching is not supported on this platform.");
+	return false;
+#endif
+}
+
+void LibraryWatcher::Stop() {
+	p_running = false;
+#ifdef __linux__
+	if (p_wake >= 0) {
+		const std::uint64_t one = 1;
+		[[maybe_unused]] const ssize_t written = write(p_wake, &one, sizeof(one));
+	}
+	if (p_thread.joinable()) {
+		p_thread.join();
+	}
+	if (p_inotify >= 0) close(p_inotify);
+	if (p_wake >= 0) close(p_wake);
+#endif
+	p_inotify = p_wake = -1;
+	p_folders.clear();
+	p_pending.clear();
+	p_removedFolders.clear();
+	p_overflow = p_batchOpen = false;
+}
+
+void LibraryWatcher::Run() {
+#ifdef __linux__
+	// Watches first, so nothing that changes during the reconcile slips through
+	WatchTree("", false);
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PATH, "Watching ", p_folders.size(), " folders for changes.");
+	if (p_reconcile) {
+		Reconcile();
+	}
+
+	pollfd fds[2] = {{p_inotify, POLLIN, 0}, {p_wake, POLLIN, 0}};
+	while (p_running) {
+		int timeout = -1;
+		if (p_batchOpen) {
+			const auto due = std::min(p_lastEvent + DebounceDelay, p_firstEvent + MaxDelay);
+			timeout = static_cast<int>(std::max<std::int64_t>(0,
+				std::chrono::duration_cast<std::chrono::milliseconds>(due - std::chrono::steady_clock::now()).count()));
+		}
+		const int ready = poll(fds, 2, timeout);
+		if (ready < 0 && errno != EINTR) {
+			Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_PATH, "Stopped watching the library: ", std::strerror(errno));
+			break;
+		}
+		if (ready > 0 && (fds[0].revents & POLLIN)) {
+			ReadEvents();
+		}
+		if (p_batchOpen) {
+			const auto now = std::chrono::steady_clock::now();
+			if (now >= p_lastEvent + DebounceDelay || now >= p_firstEvent + MaxDelay) {
+				Flush();
+			}
+		}
+	}
+#endif
+}
+
+void LibraryWatcher::ReadEvents() {
+#ifdef __linux__
+	alignas(inotify_event) char buffer[64 * 1024];
+	for (;;) {
+		const ssize_t length = read(p_inotify, buffer, sizeof(buffer));
+		if (length <= 0) {
+			return; // Drained (EAGAIN)
+		}
+		for (const char* position = buffer; position < buffer + length;) {
+			const auto* event = reinterpret_cast<const inotify_event*>(position);
+			position += sizeof(inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				p_overflow = true;
+				Touch();
+				continue;
+			}
+			const auto folder = p_folders.find(event->wd);
+			if (folder == p_folders.end()) {
+				continue;
+			}
+			if (event->mask & IN_IGNORED) {
+				p_folders.erase(folder);
+				continue;
+			}
+			if (event->len == 0) {
+				// The folder itself, its parent reports that, unless it is the root
+				if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) && folder->second.empty()) {
+					FolderRemoved("");
+				}
+				continue;
+			}
+
+			const std::string child = ChildPath(folder->second, event->name);
+			if (event->mask & IN_ISDIR) {
+				if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+					WatchTree(child, true); // May already hold files, list just this one
+				} else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+					FolderRemoved(child);
+				}
+			} else if (LibraryScanner::IsMediaFile(child)) {
+				// Created files are reported once they are written (IN_CLOSE_WRITE), not half copied
+				if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+					p_pending[child] = true;
+					Touch();
+				} else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+					p_pending[child] = false;
+					Touch();
+				}
+			}
+		}
+	}
+#endif
+}
+
+void LibraryWatcher::Touch() {
+	const auto now = std::chrono::steady_clock::now();
+	if (!p_batchOpen) {
+		p_batchOpen = true;
+		p_firstEvent = now;
+	}
+	p_lastEvent = now;
+}
+
+void LibraryWatcher::Flush() {
+	p_batchOpen = false;
+	if (p_overflow) {
+		// The kernel dropped events, what they said is unknown: reconcile and watch what is missing
+		Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_PATH, "Library events were dropped, reconciling.");
+		p_overflow = false;
+		p_pending.clear();
+		p_removedFolders.clear();
+		Reconcile(true);
+		return;
+	}
+
+	LibraryChanges changes;
+	changes.s_removedFolders = std::move(p_removedFolders);
+	p_removedFolders.clear();
+	for (auto& [file, exists] : p_pending) {
+		(exists ? changes.s_added : changes.s_removed).push_back(file); // Sorted, p_pending is ordered
+	}
+	p_pending.clear();
+	if (changes.Empty()) {
+		return;
+	}
+
+	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PATH, "Library changed: ", changes.s_added.size(), " added, ",
+				changes.s_removed.size(), " removed, ", changes.s_removedFolders.size(), " folders removed.");
+	if (p_onChange) {
+		p_onChange(std::move(changes));
+	}
+}
+
+void LibraryWatcher::Reconcile(bool Rewatch) {
+	// Incremental, only the folders whose mtime moved since the last scan are listed
+	LibraryScanner scanner(p_root);
+	LibraryChanges changes;
+	changes.s_listing = scanner.Scan();
+
+	if (Rewatch) {
+		// A folder the scan found unchanged was there under that path at the last scan, so it kept its watch.
+		// A listed one may be new (or renamed): watch it, without a walk, the scan listed what is below it.
+		size_t changedSince = 0;
+		for (const auto& [folder, mtime] : scanner.GetListedFolders()) {
+			std::error_code ec;
+			const fs::path full = folder.empty() ? p_root : p_root / fs::path(folder);
+			if (AddWatch(folder) && fs::last_write_time(full, ec).time_since_epoch().count() != mtime && !ec) {
+				// Changed between the listing and the watch: list it again, what it holds is reported as new
+				WatchTree(folder, true);
+				++changedSince;
+			}
+		}
+		Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PATH, "Rewatched ", scanner.GetListedFolders().size(), " changed folders (",
+					changedSince, " listed again), ", p_folders.size(), " watched.");
+	}
+
+	if (p_onChange) {
+		p_onChange(std::move(changes));
+	}
+}
+
+bool LibraryWatcher::AddWatch(const std::string& Folder) {
+#ifdef __linux__
+	const fs::path full = Folder.empty() ? p_root : p_root / fs::path(Folder);
+	const std::uint32_t mask = Folder.empty() ? WatchMask : WatchMask | IN_DONT_FOLLOW;
+	const int watch = inotify_add_watch(p_inotify, full.c_str(), mask);
+	if (watch < 0) {
+		if (errno == ENOSPC && !p_watchLimitLogged) {
+			p_watchLimitLogged = true;
+			Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_PATH, "Out of inotify watches (fs.inotify.max_user_watches), "
+						"changes below ", full.string(), " and other folders are not seen.");
+		}
+		return false;
+	}
+	p_folders[watch] = Folder; // The same watch again when the folder already had one
+	return true;
+#else
+	(void)Folder;
+	return false;
+#endif
+}
+
+void LibraryWatcher::WatchTree(const std::string& Folder, bool Report) {
+#ifdef __linux__
+	if (!AddWatch(Folder)) {
+		return;
+	}
+
+	const fs::path full = Folder.empty() ? p_root : p_root / fs::path(Folder);
+	std::error_code ec;
+	for (fs::directory_iterator it(full, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec)) {
+		std::error_code status;
+		const std::string child = ChildPath(Folder, it->path().filename().string());
+		// Like the scanner: linked folders are not followed, linked files are
+		if (fs::is_directory(it->symlink_status(status))) {
+			WatchTree(child, Report);
+		} else if (Report && it->is_regular_file(status) && LibraryScanner::IsMediaFile(it->path())) {
+			p_pending[child] = true;
+			Touch();
+		}
+	}
+#else
+	(void)Folder;
+	(void)Report;
+#endif
+}
+
+void LibraryWatcher::UnwatchTree(const std::string& Folder) {
+	for (auto it = p_folders.begin(); it != p_folders.end();) {
+		if (IsBelow(it->second, Folder)) {
+#ifdef __linux__
+			inotify_rm_watch(p_inotify, it->first);
+#endif
+			it = p_folders.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void LibraryWatcher::FolderRemoved(const std::string& Folder) {
+	// Moved away or deleted, a move inside the library shows up again as a new folder
+	UnwatchTree(Folder);
+
+	// What this batch said about things below it is void now
+	for (auto it = p_pending.begin(); it != p_pending.end();) {
+		it = IsBelow(it->first, Folder) ? p_pending.erase(it) : std::next(it);
+	}
+	std::erase_if(p_removedFolders, [&Folder](const std::string& Removed) { return IsBelow(Removed, Folder); });
+	p_removedFolders.push_back(Folder);
+	Touch();
+}
@@ -0,0 +1,98 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: LibraryWatcher.hpp
+ *  Lib: Beeplayer Live Library Watcher definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-08-12
+ *  Type: FileSystem
+ */
+
+#ifndef LIBRARYWATCHER_HPP
+#define LIBRARYWATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// What changed in the library, relative paths (generic separators). Applied in this order: the full
+// listing if there is one, then the removed folders, the removed files, and the added files.
+struct LibraryChanges {
+	std::optional<std::vector<std::string>> s_listing; // Every media file, sorted (a reconcile)
+	std::vector<std::string> s_removedFolders;          // Everything below these is gone
+	std::vector<std::string> s_removed;
+	std::vector<std::string> s_added;
+
+	bool Empty() const { return !s_listing && s_removedFolders.empty() && s_removed.empty() && s_added.empty(); }
+};
+
+// Follows the library folder while the player runs (Linux inotify, one watch per folder). Events are
+// coalesced per path and handed out in batches once the folder has been quiet for DebounceDelay, so
+// copying an album in is one change, not one per file. Folders that appear are listed on their own.
+// When the kernel dropped events the library is reconciled through the incremental LibraryScanner,
+// which only lists the folders that changed, and only those get their watch added again.
+class LibraryWatcher {
+	public:
+		static constexpr std::chrono::milliseconds DebounceDelay{500}; // Quiet time before a batch goes out
+		static constexpr std::chrono::milliseconds MaxDelay{3000};     // A long copy still shows up as it goes
+
+		// From the watcher thread
+		using ChangeCallback = std::function<void(LibraryChanges Changes)>;
+
+		LibraryWatcher(fs::path Root, ChangeCallback OnChange);
+		~LibraryWatcher();
+
+		LibraryWatcher(const LibraryWatcher&) = delete;
+		LibraryWatcher& operator=(const LibraryWatcher&) = delete;
+
+		// Reconcile: also report a full listing once the watches are in place, for a track list that
+		// came from the index and may miss what changed while the player was closed.
+		// False when watching is not supported here or could not be set up.
+		bool Start(bool Reconcile = false);
+		void Stop();
+
+		static bool IsSupported();
+
+	private:
+		fs::path p_root;
+		ChangeCallback p_onChange;
+
+		std::thread p_thread;
+		std::atomic<bool> p_running{false};
+		bool p_reconcile = false;
+		int p_inotify = -1;
+		int p_wake = -1; // Written by Stop() to end the wait
+
+		std::unordered_map<int, std::string> p_folders; // Watch -> relative folder, "" is the root
+		bool p_watchLimitLogged = false;
+
+		// Coalesced since the last batch, the last event of a path wins
+		std::map<std::string, bool> p_pending;     // File -> exists
+		std::vector<std::string> p_removedFolders;
+		bool p_overflow = false;
+		bool p_batchOpen = false;
+		std::chrono::steady_clock::time_point p_firstEvent;
+		std::chrono::steady_clock::time_point p_lastEvent;
+
+		void Run();
+		void ReadEvents();
+		void Flush();
+		// Rewatch: events were lost, the folders the scan had to list may lack a watch
+		void Reconcile(bool Rewatch = false);
+
+		// Watch Folder and everything below it, Report: the media files found there are new
+		void WatchTree(const std::string& Folder, bool Report);
+		bool AddWatch(const std::string& Folder); // Just this folder, false when it can't be watched
+		void UnwatchTree(const std::string& Folder);
+		void FolderRemoved(const std::string& Folder);
+		void Touch();
+};
+
+#endif //LIBRARYWATCHER_HPP
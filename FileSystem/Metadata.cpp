@@ -15,10 +15,56 @@
 #include <taglib/id3v2tag.h>
 #include <taglib/attachedpictureframe.h>
 #include <taglib/infotag.h>  // WAV 的 RIFF INFO 标签
+#include <taglib/audioproperties.h>
 #include <cctype> // std::tolower
 #include <locale>
 #include <codecvt>
 
+namespace {
+    void fillAudioProperties(const TagLib::AudioProperties* audio, TrackInfo& info) {
+        if (audio) {
+            info.s_durationMs = static_cast<std::uint32_t>(audio->lengthInMilliseconds());
+            info.s_sampleRate = static_cast<std::uint32_t>(audio->sampleRate());
+            info.s_channels = static_cast<std::uint16_t>(audio->channels());
+        }
+    }
+
+    // Same picks as getSongTitle() / getSongProducer(), from a single open
+    template <typename FileName>
+    bool readTrackInfo(const FileName& filePath, bool wav, TrackInfo& info) {
+        if (wav) {
+            TagLib::RIFF::WAV::File file(filePath.c_str());
+            if (!file.isValid()) {
+                return false;
+            }
+            const TagLib::ID3v2::Tag* id3 = file.ID3v2Tag();
+            const TagLib::RIFF::Info::Tag* riff = file.InfoTag();
+            if (id3 && !id3->title().isEmpty()) info.s_title = id3->title().to8Bit(true);
+            else if (riff) info.s_title = riff->title().to8Bit(true);
+            if (id3 && !id3->artist().isEmpty()) info.s_artist = id3->artist().to8Bit(true);
+            else if (riff && !riff->artist().isEmpty()) info.s_artist = riff->artist().to8Bit(true);
+            else if (riff) info.s_artist = riff->comment().to8Bit(true);
+            fillAudioProperties(file.audioProperties(), info);
+        } else {
+            TagLib::FileRef file(filePath.c_str());
+            if (file.isNull() || !file.tag()) {
+                return false;
+            }
+            info.s_title = file.tag()->title().to8Bit(true);
+            const TagLib::PropertyMap properties = file.file()->properties();
+            for (const char* key : {"PRODUCER", "ARTIST", "ALBUMARTIST"}) {
+                if (properties.contains(key)) {
+                    info.s_artist = properties[key].front().to8Bit(true);
+                    break;
+                }
+            }
+            fillAudioProperties(file.audioProperties(), info);
+        }
+        info.s_hasTags = true;
+        return true;
+    }
+}
+
 // u8str
 // 辅助函数：检查文件扩展名
 bool AudioMetadataReader::isMP3(const std::string& filePath) const {
@@ -104,6 +150,10 @@ std::vector<unsigned char> AudioMetadataReader::getAlbumCover(const std::string&
     return imageData;
 }
 
+bool AudioMetadataReader::getTrackInfo(const std::string& filePath, TrackInfo& info) const {
+    return readTrackInfo(filePath, isWAV(filePath), info);
+}
+
 // WAV 文件元数据处理
 std::string AudioMetadataReader::getWAVTitle(const std::string& filePath) const {
     TagLib::RIFF::WAV::File file(filePath.c_str());
@@ -224,6 +274,10 @@ std::vector<unsigned char> AudioMetadataReader::getAlbumCover(const std::wstring
     return imageData;
 }
 
+bool AudioMetadataReader::getTrackInfo(const std::wstring& filePath, TrackInfo& info) const {
+    return readTrackInfo(filePath, isWAV(filePath), info);
+}
+
 // WAV 文件元数据处理
 std::string AudioMetadataReader::getWAVTitle(const std::wstring& filePath) const {
     TagLib::RIFF::WAV::File file(filePath.c_str());
@@ -9,9 +9,24 @@
 #ifndef METADATA_HPP
 #define METADATA_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+// Everything the library index keeps about a track
+struct TrackInfo {
+    std::uint64_t s_size = 0;         // File size and mtime it was read at, to tell when it went stale
+    std::int64_t s_mtime = 0;
+    std::uint32_t s_durationMs = 0;
+    std::uint32_t s_sampleRate = 0;
+    std::uint16_t s_channels = 0;
+    bool s_hasTags = false;           // false: only the file is known, tags are read on first use
+    std::string s_title;
+    std::string s_artist;             // Picked like getSongProducer()
+    std::uint64_t s_coverOffset = 0;  // Picture bytes inside the audio file (first APIC frame)
+    std::uint32_t s_coverSize = 0;    // 0: no cover, or one that can't be read in place
+};
+
 class AudioMetadataReader {
 public:
     AudioMetadataReader(const AudioMetadataReader&) = delete;
@@ -32,6 +47,10 @@ public:
     std::vector<unsigned char> getAlbumCover(const std::string& filePath) const;
     std::vector<unsigned char> getAlbumCover(const std::wstring& filePath) const;  // 新增宽字符版本
 
+    // Tags and audio properties with one open of the file (size, mtime and cover are the index's job)
+    bool getTrackInfo(const std::string& filePath, TrackInfo& info) const;
+    bool getTrackInfo(const std::wstring& filePath, TrackInfo& info) const;
+
 private:
     AudioMetadataReader() = default;
 
@@ -6,85 +6,195 @@
  *  Type: FileSystem
  */
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
 #include "Path.hpp"
 #include "../Log/LogSystem.hpp"
 
-void Path::InitSongList() {
-	p_song_names.clear();
-	if (!fs::exists(p_root_path) || !fs::is_directory(p_root_path))
-		return;
-
-	try {
-		auto iterator_opt = fs::directory_options::skip_permission_denied;
-		auto iterator_rec = fs::recursive_directory_iterator(p_root_path, iterator_opt);
-
-		for (const auto &file : iterator_rec) {
-			try {
-				if (!file.is_regular_file())
-					continue;
-
-				std::string extension = file.path().extension().string();
-				std::ranges::transform(extension.begin(), extension.end(), extension.begin(),
-									   [](unsigned char c) { return std::tolower(c); });
-
-				if (extension == ".mp3" || extension == ".wav") {
-					// 关键修改：存储相对于根目录的相对路径
-					fs::path relative_path = fs::relative(file.path(), p_root_path);
-					p_song_names.push_back(relative_path.generic_string()); // 使用通用格式路径分隔符
-				}
-			} catch (...) {
-				// Skip File Error
-			}
-		}
-	} catch (...) {
-		// Skip Folder Error
-	}
+void Path::InitSongList(const LibraryScanner::BatchCallback& OnBatch) {
+	// Parallel, and only lists the folders that changed since the last scan
+	LibraryScanner scanner(p_root_path);
+	p_tracks = TrackStore::FromSorted(scanner.Scan(OnBatch));
+	p_index.Save(*p_tracks);
 }
 
-Path::Path(const std::string &root) : p_root_path(root) {
+Path::Path(const std::string &root, const LibraryScanner::BatchCallback& OnBatch) : p_root_path(root), p_index(p_root_path) {
 	Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_LOG, "Set Root Path: " + root);
-	InitSongList();
+
+	// The list of the last session comes straight from the index, the folders are only walked without one
+	if (p_index.Open()) {
+		TrackStore::Builder builder;
+		p_index.ForEachPath([&builder](std::string_view relative) { builder.Add(relative); });
+		p_tracks = builder.Finish();
+		p_from_index = !p_tracks->Empty();
+	}
+	if (p_tracks->Empty()) {
+		InitSongList(OnBatch);
+	}
+}
+
+Path::~Path() {
+	if (p_list_changed || p_index.HasChanges()) {
+		p_index.Save(*p_tracks);
+	}
 }
 
 std::string Path::NextFilePath() {
-	if (p_song_names.empty())
+	if (p_tracks->Empty())
 		return "";
 
-	p_current_index = (p_current_index + 1) % p_song_names.size();
+	p_current_index = (p_current_index + 1) % p_tracks->Size();
 	// 拼接完整路径（自动处理路径分隔符）
-	return (p_root_path / p_song_names[p_current_index]).string();
+	return FilePath(p_current_index);
 }
 
 std::string Path::PrevFilePath() {
-	if (p_song_names.empty())
+	if (p_tracks->Empty())
 		return "";
 
-	p_current_index = (p_current_index - 1 + p_song_names.size()) % p_song_names.size();
-	return (p_root_path / p_song_names[p_current_index]).string();
+	p_current_index = (p_current_index - 1 + p_tracks->Size()) % p_tracks->Size();
+	return FilePath(p_current_index);
 }
 
 std::string Path::CurrentFilePath() const {
-	if (p_song_names.empty())
+	if (p_tracks->Empty())
 		return "";
-	return (p_root_path / p_song_names[p_current_index]).string();
+	return FilePath(p_current_index);
 }
 
+std::string Path::PeekNextFilePath(size_t Ahead) const {
+	if (p_tracks->Empty())
+		return "";
+	return FilePath((p_current_index + Ahead) % p_tracks->Size());
+}
+
+std::string Path::FilePath(size_t Index) const {
+	if (Index >= p_tracks->Size())
+		return "";
+	return (p_root_path / p_tracks->Path(Index)).string();
+}
+
+TrackId Path::CurrentTrackId() const {
+	if (p_current_index >= p_tracks->Size())
+		return TrackStore::NoTrack;
+	return p_tracks->Id(p_current_index);
+}
 
 std::string Path::GetFileName(const std::string &path) { return fs::path(path).filename().string(); }
 
+fs::path Path::CacheDirectory() {
+	fs::path base;
+#ifdef _WIN32
+	if (const char* local = std::getenv("LOCALAPPDATA")) base = local;
+#else
+	if (const char* xdg = std::getenv("XDG_CACHE_HOME")) base = xdg;
+	else if (const char* home = std::getenv("HOME")) base = fs::path(home) / ".cache";
+#endif
+	std::error_code ec;
+	if (base.empty()) base = fs::temp_directory_path(ec);
+
+	fs::path dir = base / "beeplayer";
+	fs::create_directories(dir, ec);
+	return dir;
+}
+
+fs::path Path::LibraryCacheFile(const fs::path& Root, const std::string& Extension) {
+	// FNV-1a of the absolute root, one set of files per library
+	std::uint64_t hash = 1469598103934665603ULL;
+	for (const char c : fs::absolute(Root).generic_string()) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+	}
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.", static_cast<unsigned long long>(hash));
+	return CacheDirectory() / "library" / (name + Extension);
+}
+
 void Path::SetIndex(size_t index) {
 	this->p_current_index = index;
 }
 
 void Path::GetAllSongNames() const {
-	for(const auto& it : p_song_names) {
-		std::cout << it << std::endl;
+	for (size_t i = 0; i < p_tracks->Size(); ++i) {
+		std::cout << p_tracks->Path(i) << std::endl;
+	}
+}
+
+size_t Path::IndexOf(const std::string& Relative) const {
+	return p_tracks->Find(Relative);
+}
+
+bool Path::ApplyChanges(const LibraryChanges& Changes) {
+	const TrackStore& old = *p_tracks;
+	const TrackId current = CurrentTrackId();
+	const std::string currentPath = old.Empty() ? "" : old.Path(p_current_index);
+
+	// Both sides are sorted: one merge walk over the old store and the new paths (the listing, or what
+	// was added), the old tracks keep their ids. Paths are put together in a single buffer as it goes.
+	const std::vector<std::string>& incoming = Changes.s_listing ? *Changes.s_listing : Changes.s_added;
+	const bool keepOld = !Changes.s_listing; // A listing is the whole library, what it doesn't have is gone
+	const auto removed = [&Changes](const std::string& Relative) {
+		if (std::binary_search(Changes.s_removed.begin(), Changes.s_removed.end(), Relative))
+			return true;
+		return std::any_of(Changes.s_removedFolders.begin(), Changes.s_removedFolders.end(), [&Relative](const std::string& Folder) {
+			return Folder.empty() || (Relative.size() > Folder.size() && Relative.compare(0, Folder.size(), Folder) == 0 && Relative[Folder.size()] == '/');
+		});
+	};
+
+	TrackStore::Builder builder(old.NextId());
+	size_t dropped = 0, added = 0;
+	size_t next = 0;
+	std::string path;
+	const auto loadOld = [&]() {
+		path.clear();
+		if (next < old.Size())
+			old.AppendPath(next, path);
+	};
+	loadOld();
+	for (const auto& relative : incoming) {
+		while (next < old.Size() && path < relative) {
+			if (keepOld && !removed(path))
+				builder.Add(path, old.Id(next));
+			else
+				++dropped;
+			++next;
+			loadOld();
+		}
+		if (next < old.Size() && path == relative) {
+			builder.Add(relative, old.Id(next)); // Known (and written again): same track
+			++next;
+			loadOld();
+		} else {
+			builder.Add(relative);
+			++added;
+		}
+	}
+	for (; next < old.Size(); ++next, loadOld()) {
+		if (keepOld && !removed(path))
+			builder.Add(path, old.Id(next));
+		else
+			++dropped;
+	}
+	if (dropped == 0 && added == 0)
+		return false;
+
+	p_tracks = builder.Finish();
+	p_current_index = p_tracks->IndexOf(current);
+	if (p_tracks->Empty()) {
+		p_current_index = 0;
+	} else if (p_current_index == p_tracks->Size()) {
+		p_current_index = (p_tracks->LowerBound(currentPath) + p_tracks->Size() - 1) % p_tracks->Size();
 	}
+	p_list_changed = true;
+	return true;
 }
 
 void Path::Rescan() {
-	InitSongList();
-	p_current_index = 0;
+	LibraryScanner scanner(p_root_path);
+	LibraryChanges changes;
+	changes.s_listing = scanner.Scan();
+	ApplyChanges(changes);
 }
\ No newline at end of file
@@ -10,23 +10,36 @@
 #define PATH_HPP
 
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "LibraryIndex.hpp"
+#include "LibraryScanner.hpp"
+#include "LibraryWatcher.hpp"
+#include "TrackStore.hpp"
+
 namespace fs = std::filesystem;
 
 class Path {
 	private:
 		fs::path p_root_path;
-		std::vector<std::string> p_song_names;
+		std::shared_ptr<const TrackStore> p_tracks = std::make_shared<const TrackStore>();
 		size_t p_current_index = 0;
+		LibraryIndex p_index;
+		bool p_from_index = false;
+		bool p_list_changed = false; // The list changed since the index was written, it is written again in ~Path()
 
 		// Init The Song List
-		void InitSongList();
+		void InitSongList(const LibraryScanner::BatchCallback& OnBatch = nullptr);
 
 	public:
-		// Constructor
-		explicit Path(const std::string& root);
+		// Constructor, loads the library index of the root, or scans the root when there is none.
+		// OnBatch sees the files while the scan runs (from scanner threads), the index needs no waiting.
+		explicit Path(const std::string& root, const LibraryScanner::BatchCallback& OnBatch = nullptr);
+
+		// Saves the tags read this session and the changed list into the index
+		~Path();
 
 		// Get Next File Path
 		std::string NextFilePath();
@@ -37,12 +50,36 @@ class Path {
 		// Get Current File Path
 		std::string CurrentFilePath() const;
 
-		// Get all the name of the song list
-		const std::vector<std::string>& GetFiles() const { return p_song_names; }
+		// Get the file that NextFilePath() would return (Ahead times), without moving the index
+		std::string PeekNextFilePath(size_t Ahead = 1) const;
+
+		// Get the full path of the Index-th song, without moving the index
+		std::string FilePath(size_t Index) const;
+
+		// The library folder
+		const fs::path& Root() const { return p_root_path; }
+
+		// The list came from the index, it may miss what changed while the player was closed
+		bool LoadedFromIndex() const { return p_from_index; }
+
+		// Tags, audio properties and cover location of the tracks, kept across launches
+		LibraryIndex& Library() { return p_index; }
+
+		// The song list, shared: holding it is a pointer copy, it is replaced (not changed) when the library changes
+		const std::shared_ptr<const TrackStore>& GetTracks() const { return p_tracks; }
+
+		// Stable id of the current song
+		TrackId CurrentTrackId() const;
 
 		// Get file name
 		static std::string GetFileName(const std::string& path);
 
+		// Per-user cache directory for Beeplayer (created on demand)
+		static fs::path CacheDirectory();
+
+		// Cache file kept for one library root: CacheDirectory()/library/<hash of the root>.<Extension>
+		static fs::path LibraryCacheFile(const fs::path& Root, const std::string& Extension);
+
 		// Get current index
 		size_t Index() const { return p_current_index; }
 
@@ -50,14 +87,23 @@ class Path {
 		void SetIndex(size_t index);
 
 		// Get Song Count
-		size_t TotalSong() const { return p_song_names.size(); }
+		size_t TotalSong() const { return p_tracks->Size(); }
 
 		// Get All Song Names
 		void GetAllSongNames() const;
 
 
 
-		// Rescan the folder
+		// Position of a relative path in the list, TotalSong() when it is not there
+		size_t IndexOf(const std::string& Relative) const;
+
+		// Apply what the watcher saw. The current track stays current; when it is the one that went, the index
+		// moves to the track before the gap so the next one is the one that followed it. False when the list
+		// did not change. The library index is only marked stale, rewriting it for every batch would stall the
+		// engine thread: ~Path() saves it once (after a crash the watcher's reconcile at the next start catches up).
+		bool ApplyChanges(const LibraryChanges& Changes);
+
+		// Rescan the folder (only the folders that changed are listed), keeps the current track
 		void Rescan();
 };
 
@@ -0,0 +1,164 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: TrackStore.cpp
+ *  Lib: Beeplayer Compact Track Path Storage
+ *  Author: Romi Brooks
+ *  Date: 2025-08-15
+ *  Type: FileSystem
+ */
+#include "TrackStore.hpp"
+
+#include <algorithm>
+
+#include "../Log/LogSystem.hpp"
+
+TrackStore::Builder::Builder(TrackId FirstId) : p_store(std::make_shared<TrackStore>()) {
+	p_store->p_nextId = FirstId;
+}
+
+void TrackStore::Builder::Add(std::string_view Relative, TrackId Id) {
+	const size_t slash = Relative.rfind('/');
+	const std::string_view folder = slash == std::string_view::npos ? std::string_view() : Relative.substr(0, slash);
+	const std::string_view name = slash == std::string_view::npos ? Relative : Relative.substr(slash + 1);
+	if (name.empty() || name.size() > std::numeric_limits<std::uint16_t>::max()) {
+		Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_PATH, "Skipped a track with an unusable name: ", Relative);
+		return;
+	}
+
+	// Sorted input: the tracks of a folder come one after another
+	if (folder != p_lastFolder) {
+		p_lastFolderId = FolderId(folder);
+		p_lastFolder = folder;
+	}
+
+	TrackStore& store = *p_store;
+	if (Id == NoTrack) {
+		Id = store.p_nextId++;
+	} else if (Id >= store.p_nextId) {
+		store.p_nextId = Id + 1;
+	}
+	store.p_tracks.push_back({p_lastFolderId, static_cast<std::uint32_t>(store.p_names.size()), Id,
+							  static_cast<std::uint16_t>(name.size())});
+	store.p_names.append(name);
+}
+
+std::uint32_t TrackStore::Builder::FolderId(std::string_view Folder) {
+	if (Folder.empty()) {
+		return RootFolder;
+	}
+	const std::string key(Folder);
+	const auto found = p_folderIds.find(key);
+	if (found != p_folderIds.end()) {
+		return found->second;
+	}
+
+	const size_t slash = Folder.rfind('/');
+	const std::uint32_t parent = FolderId(slash == std::string_view::npos ? std::string_view() : Folder.substr(0, slash));
+	const std::string_view name = slash == std::string_view::npos ? Folder : Folder.substr(slash + 1);
+
+	TrackStore& store = *p_store;
+	const auto id = static_cast<std::uint32_t>(store.p_folders.size());
+	store.p_folders.push_back({parent, static_cast<std::uint32_t>(store.p_names.size()), static_cast<std::uint32_t>(name.size())});
+	store.p_names.append(name);
+	p_folderIds.emplace(key, id);
+	return id;
+}
+
+std::shared_ptr<const TrackStore> TrackStore::Builder::Finish() {
+	TrackStore& store = *p_store;
+	store.p_byId.reserve(store.p_tracks.size());
+	for (size_t i = 0; i < store.p_tracks.size(); ++i) {
+		store.p_byId.emplace_back(store.p_tracks[i].s_id, static_cast<std::uint32_t>(i));
+	}
+	std::sort(store.p_byId.begin(), store.p_byId.end());
+
+	store.p_names.shrink_to_fit();
+	store.p_folders.shrink_to_fit();
+	store.p_tracks.shrink_to_fit();
+	p_folderIds.clear();
+	return std::move(p_store);
+}
+
+TrackStore::TrackStore() {
+	p_folders.push_back({RootFolder, 0, 0});
+}
+
+std::shared_ptr<const TrackStore> TrackStore::FromSorted(const std::vector<std::string>& Sorted) {
+	Builder builder;
+	for (const auto& relative : Sorted) {
+		builder.Add(relative);
+	}
+	return builder.Finish();
+}
+
+std::string_view TrackStore::Name(size_t Index) const {
+	const Track& track = p_tracks[Index];
+	return std::string_view(p_names).substr(track.s_nameOffset, track.s_nameLength);
+}
+
+std::string_view TrackStore::FolderName(std::uint32_t Folder) const {
+	const FolderNode& folder = p_folders[Folder];
+	return std::string_view(p_names).substr(folder.s_nameOffset, folder.s_nameLength);
+}
+
+void TrackStore::AppendFolder(std::uint32_t Folder, std::string& Out) const {
+	if (Folder == RootFolder) {
+		return;
+	}
+	AppendFolder(p_folders[Folder].s_parent, Out);
+	Out.append(FolderName(Folder));
+	Out.push_back('/');
+}
+
+void TrackStore::AppendPath(size_t Index, std::string& Out) const {
+	AppendFolder(p_tracks[Index].s_folder, Out);
+	Out.append(Name(Index));
+}
+
+std::string TrackStore::Path(size_t Index) const {
+	std::string path;
+	AppendPath(Index, path);
+	return path;
+}
+
+size_t TrackStore::IndexOf(TrackId Id) const {
+	const auto found = std::lower_bound(p_byId.begin(), p_byId.end(), std::make_pair(Id, std::uint32_t(0)));
+	if (found == p_byId.end() || found->first != Id) {
+		return Size();
+	}
+	return found->second;
+}
+
+int TrackStore::Compare(size_t Index, std::string_view Relative, std::string& Scratch) const {
+	Scratch.clear();
+	AppendPath(Index, Scratch);
+	return std::string_view(Scratch).compare(Relative);
+}
+
+size_t TrackStore::LowerBound(std::string_view Relative) const {
+	std::string scratch;
+	size_t first = 0, count = Size();
+	while (count > 0) {
+		const size_t half = count / 2;
+		if (Compare(first + half, Relative, scratch) < 0) {
+			first += half + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+	return first;
+}
+
+size_t TrackStore::Find(std::string_view Relative) const {
+	const size_t index = LowerBound(Relative);
+	std::string scratch;
+	if (index == Size() || Compare(index, Relative, scratch) != 0) {
+		return Size();
+	}
+	return index;
+}
+
+size_t TrackStore::MemoryBytes() const {
+	return p_names.capacity() + p_folders.capacity() * sizeof(FolderNode) + p_tracks.capacity() * sizeof(Track) +
+		   p_byId.capacity() * sizeof(p_byId[0]);
+}
@@ -0,0 +1,107 @@
+/*  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *  File Name: TrackStore.hpp
+ *  Lib: Beeplayer Compact Track Path Storage definitions
+ *  Author: Romi Brooks
+ *  Date: 2025-08-15
+ *  Type: FileSystem
+ */
+
+#ifndef TRACKSTORE_HPP
+#define TRACKSTORE_HPP
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Stays with a track for the whole session, whatever is added or removed around it
+using TrackId = std::uint32_t;
+
+// The track list, sorted by relative path. Every name (folder or file) is stored once in a single arena,
+// folders form a prefix tree, so a track costs its file name and a few integers rather than a full path
+// in its own allocation. A store never changes once built: it is shared as a
+// std::shared_ptr<const TrackStore>, copying the library is copying that pointer.
+class TrackStore {
+	public:
+		static constexpr TrackId NoTrack = std::numeric_limits<TrackId>::max();
+		static constexpr std::uint32_t RootFolder = 0;
+
+		// Fills a store from relative paths (generic separators) given in sorted order
+		class Builder {
+			public:
+				// FirstId: where new ids start, Next() of the store this one replaces
+				explicit Builder(TrackId FirstId = 0);
+
+				// Id: the track's id in the previous store, NoTrack for a new track
+				void Add(std::string_view Relative, TrackId Id = NoTrack);
+
+				std::shared_ptr<const TrackStore> Finish();
+
+			private:
+				std::shared_ptr<TrackStore> p_store;
+				std::unordered_map<std::string, std::uint32_t> p_folderIds; // Folder path -> node, only while building
+				std::string p_lastFolder;
+				std::uint32_t p_lastFolderId = RootFolder;
+
+				std::uint32_t FolderId(std::string_view Folder);
+		};
+
+		TrackStore();
+
+		static std::shared_ptr<const TrackStore> FromSorted(const std::vector<std::string>& Sorted);
+
+		size_t Size() const { return p_tracks.size(); }
+		bool Empty() const { return p_tracks.empty(); }
+
+		// File name of the Index-th track, a view into the arena (valid while the store is)
+		std::string_view Name(size_t Index) const;
+		std::uint32_t Folder(size_t Index) const { return p_tracks[Index].s_folder; }
+		std::string_view FolderName(std::uint32_t Folder) const;
+		std::uint32_t ParentFolder(std::uint32_t Folder) const { return p_folders[Folder].s_parent; }
+
+		// Relative path of the Index-th track
+		std::string Path(size_t Index) const;
+		void AppendPath(size_t Index, std::string& Out) const;
+
+		TrackId Id(size_t Index) const { return p_tracks[Index].s_id; }
+		TrackId NextId() const { return p_nextId; }
+		// Position of a track, Size() when it is not in this store
+		size_t IndexOf(TrackId Id) const;
+
+		// Position of a relative path, Size() when it is not there
+		size_t Find(std::string_view Relative) const;
+		// First position whose path is not less than Relative
+		size_t LowerBound(std::string_view Relative) const;
+
+		// Heap bytes held by the store
+		size_t MemoryBytes() const;
+
+	private:
+		struct FolderNode {
+			std::uint32_t s_parent;
+			std::uint32_t s_nameOffset;
+			std::uint32_t s_nameLength;
+		};
+
+		struct Track {
+			std::uint32_t s_folder;
+			std::uint32_t s_nameOffset;
+			TrackId s_id;
+			std::uint16_t s_nameLength;
+		};
+
+		std::string p_names; // The arena
+		std::vector<FolderNode> p_folders;
+		std::vector<Track> p_tracks;
+		std::vector<std::pair<TrackId, std::uint32_t>> p_byId; // Sorted by id
+		TrackId p_nextId = 0;
+
+		void AppendFolder(std::uint32_t Folder, std::string& Out) const;
+		int Compare(size_t Index, std::string_view Relative, std::string& Scratch) const;
+};
+
+#endif //TRACKSTORE_HPP
@@ -0,0 +1,72 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Write the audio the engine tests play: a 16-bit stereo 48 kHz WAV, a slow sweep with a little
+// noise on top, so no two stretches of the file hold the same samples (a seek that lands on the
+// wrong frame shows up). Deterministic, the same arguments give the same file.
+namespace {
+  constexpr std::uint32_t SampleRate = 48000;
+  constexpr std::uint16_t Channels = 2;
+  constexpr std::uint16_t BitsPerSample = 16;
+
+  void Put16(std::vector<unsigned char>& out, std::uint16_t value) {
+    out.push_back(static_cast<unsigned char>(value & 0xff));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+  }
+
+  void Put32(std::vector<unsigned char>& out, std::uint32_t value) {
+    Put16(out, static_cast<std::uint16_t>(value & 0xffff));
+    Put16(out, static_cast<std::uint16_t>(value >> 16));
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: make_test_tone <out.wav> [seconds]\n");
+    return -1;
+  }
+  const double seconds = argc > 2 ? std::stod(argv[2]) : 10.0;
+  const std::uint32_t frames = static_cast<std::uint32_t>(seconds * SampleRate);
+  const std::uint32_t dataBytes = frames * Channels * (BitsPerSample / 8);
+
+  std::vector<unsigned char> wav;
+  wav.reserve(44 + dataBytes);
+  wav.insert(wav.end(), {'R', 'I', 'F', 'F'});
+  Put32(wav, 36 + dataBytes);
+  wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  Put32(wav, 16);
+  Put16(wav, 1); // PCM
+  Put16(wav, Channels);
+  Put32(wav, SampleRate);
+  Put32(wav, SampleRate * Channels * (BitsPerSample / 8));
+  Put16(wav, Channels * (BitsPerSample / 8));
+  Put16(wav, BitsPerSample);
+  wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+  Put32(wav, dataBytes);
+
+  const double pi = std::acos(-1.0);
+  std::uint32_t noise = 0x12345678u;
+  double phase = 0;
+  for (std::uint32_t i = 0; i < frames; ++i) {
+    const double t = static_cast<double>(i) / SampleRate;
+    phase += 2 * pi * (110.0 + 40.0 * t) / SampleRate; // 110 Hz, up 40 Hz a second
+    for (std::uint16_t channel = 0; channel < Channels; ++channel) {
+      noise = noise * 1664525u + 1013904223u;
+      const double dither = (static_cast<double>(noise >> 8) / (1u << 24) - 0.5) * 0.02;
+      const double value = 0.5 * std::sin(phase + channel * pi / 2) + dither;
+      Put16(wav, static_cast<std::uint16_t>(static_cast<std::int16_t>(std::lround(value * 32767))));
+    }
+  }
+
+  FILE* file = fopen(argv[1], "wb");
+  if (!file || fwrite(wav.data(), 1, wav.size(), file) != wav.size()) {
+    printf("Could not write %s\n", argv[1]);
+    if (file) fclose(file);
+    return -2;
+  }
+  fclose(file);
+  return 0;
+}
@@ -0,0 +1,78 @@
+#include "../miniaudio/miniaudio.h"
+
+#include "../Engine/Buffering.hpp"
+#include "../Engine/DataCallback.hpp"
+#include "../Engine/Device.hpp"
+#include "../Engine/OfflineSink.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Offline render: play one file through the engine into the null sink (throughput) or a WAV file
+// (run it twice and compare the files, they must be identical). No sound card needed.
+// Starts paused for a while: the sink may render the fade-out, nothing after it.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: offline_render <file> [out.wav] [period_frames]\n");
+    return -1;
+  }
+  const ma_uint32 periodFrames = argc > 3 ? static_cast<ma_uint32>(std::stoul(argv[3])) : OfflineSink::DefaultPeriodFrames;
+
+  const ma_decoder_config config = AudioDevice::DecoderConfig();
+  ma_decoder decoder;
+  if (ma_decoder_init_file(argv[1], &config, &decoder) != MA_SUCCESS) {
+    printf("Could not load file: %s\n", argv[1]);
+    return -2;
+  }
+  ma_uint64 length = 0;
+  ma_decoder_get_length_in_pcm_frames(&decoder, &length);
+
+  std::unique_ptr<OfflineSink> sink;
+  if (argc > 2) sink = std::make_unique<WavSink>(argv[2], periodFrames);
+  else sink = std::make_unique<NullSink>(periodFrames);
+
+  double seconds = 0;
+  ma_uint64 pausedFrames = 0;
+  {
+    AudioBuffering buffering;
+    buffering.SetGapless(false);
+    buffering.StartFiller(&decoder, nullptr, length);
+    buffering.SetPaused(true);
+    sink->InitDeviceConfig(data_callback, &buffering.GetStreamContext());
+    sink->InitDevice();
+
+    sink->Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    pausedFrames = sink->GetFramesRendered();
+
+    // The last period is padded with silence, then the sink waits for a next track that never comes
+    const auto start = std::chrono::steady_clock::now();
+    buffering.SetPaused(false);
+    while (sink->GetFramesRendered() < length && sink->IsStarted()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sink->Stop();
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  const ma_uint64 rendered = sink->GetFramesRendered();
+  const ma_uint64 stalls = sink->GetStalls();
+  sink.reset(); // Finalizes the WAV file
+  ma_decoder_uninit(&decoder);
+
+  const double audioSeconds = static_cast<double>(length) / config.sampleRate;
+  printf("%llu frames (%.1f s) in %.3f s: %.1fx realtime, %llu frames rendered, %llu stalls\n",
+         static_cast<unsigned long long>(length), audioSeconds, seconds, audioSeconds / seconds,
+         static_cast<unsigned long long>(rendered), static_cast<unsigned long long>(stalls));
+  // The fade-out, rounded up to whole periods
+  const ma_uint64 fadeFrames = static_cast<ma_uint64>(AudioBuffering::PauseFadeSeconds * config.sampleRate);
+  const ma_uint64 pausedLimit = (fadeFrames + periodFrames - 1) / periodFrames * periodFrames;
+  if (pausedFrames > pausedLimit) {
+    printf("FAILED: %llu frames rendered while paused, at most %llu expected\n",
+           static_cast<unsigned long long>(pausedFrames), static_cast<unsigned long long>(pausedLimit));
+    return -4;
+  }
+  return stalls == 0 ? 0 : -3;
+}
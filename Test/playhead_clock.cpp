@@ -0,0 +1,111 @@
+#include "../miniaudio/miniaudio.h"
+
+#include "../Engine/Buffering.hpp"
+#include "../Engine/DataCallback.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Playhead clock: drive data_callback like a device with a fixed period and a device buffer of
+// `periods` periods, and sample the position from another thread as fast as it can. Compares the
+// raw callback position and the interpolated clock against where the simulated speaker really is.
+// Fails if the clock ever went backwards, or strayed more than a period from the speaker (a callback
+// that much late is a scheduling problem of the host, not of the clock).
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: playhead_clock <file> [seconds] [period_ms] [periods]\n");
+    return -1;
+  }
+  const int seconds = argc > 2 ? std::stoi(argv[2]) : 5;
+  const int periodMs = argc > 3 ? std::stoi(argv[3]) : 10;
+  const int periods = argc > 4 ? std::stoi(argv[4]) : 3;
+
+  const ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, 48000);
+  ma_decoder decoder;
+  if (ma_decoder_init_file(argv[1], &config, &decoder) != MA_SUCCESS) {
+    printf("Could not load file: %s\n", argv[1]);
+    return -2;
+  }
+  const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(config.format, config.channels);
+  const ma_uint32 periodFrames = config.sampleRate * periodMs / 1000;
+  const double latencyFrames = static_cast<double>(periodFrames) * periods;
+
+  const double maxClockErrorMs = periodMs;
+  double rawWorst = 0, clockWorst = 0, rawSum = 0, clockSum = 0;
+  long samples = 0, backwards = 0;
+  {
+    AudioBuffering buffering;
+    PlayheadClock playhead;
+    buffering.StartFiller(&decoder);
+    buffering.SetDeviceLatencyMs(periodMs * periods);
+    buffering.SetPaused(false);
+    ma_device device{};
+    device.pUserData = &buffering.GetStreamContext();
+
+    // Let the ring fill before the "device" starts
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::atomic<bool> done{false};
+    std::atomic<ma_int64> firstCallbackNs{0};
+    std::thread callback([&]() {
+      std::vector<ma_uint8> output(periodFrames * bytesPerFrame);
+      auto next = std::chrono::steady_clock::now();
+      const auto end = next + std::chrono::seconds(seconds);
+      while (next < end) {
+        std::this_thread::sleep_until(next);
+        if (firstCallbackNs == 0) firstCallbackNs = AudioBuffering::NowNs();
+        data_callback(&device, output.data(), NULL, periodFrames);
+        next += std::chrono::milliseconds(periodMs);
+      }
+      done = true;
+    });
+
+    // The simulated speaker plays the first frame a device buffer after the first callback
+    double last = 0;
+    while (!done) {
+      const PlaybackSnapshot snapshot = buffering.GetSnapshot();
+      const ma_int64 now = AudioBuffering::NowNs();
+      const ma_int64 start = firstCallbackNs.load();
+      if (start == 0 || snapshot.s_frame == 0) continue;
+
+      const double truth = (now - start) / 1e9 * config.sampleRate + periodFrames - latencyFrames;
+      if (truth < periodFrames) continue; // Still inside the initial latency, the clock clamps to 0 there
+      const double clock = playhead.HeardFrame(snapshot, now);
+      const double rawError = std::fabs(static_cast<double>(snapshot.s_frame) - truth) * 1000.0 / config.sampleRate;
+      const double clockError = std::fabs(clock - truth) * 1000.0 / config.sampleRate;
+      rawWorst = std::max(rawWorst, rawError);
+      clockWorst = std::max(clockWorst, clockError);
+      rawSum += rawError;
+      clockSum += clockError;
+      if (clock < last) ++backwards;
+      last = clock;
+      ++samples;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    callback.join();
+  }
+  ma_decoder_uninit(&decoder);
+
+  if (samples == 0) {
+    printf("No samples taken\n");
+    return -3;
+  }
+  printf("period %d ms x %d, %ld samples\n", periodMs, periods, samples);
+  printf("callback position error (ms): mean %.3f, max %.3f\n", rawSum / samples, rawWorst);
+  printf("playhead clock error (ms):    mean %.3f, max %.3f, went backwards %ld times\n", clockSum / samples, clockWorst, backwards);
+  if (backwards > 0) {
+    printf("FAIL: the playhead clock went backwards\n");
+    return 1;
+  }
+  if (clockWorst > maxClockErrorMs) {
+    printf("FAIL: playhead clock error above %.1f ms\n", maxClockErrorMs);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+#include "../miniaudio/miniaudio.h"
+
+#include "../Engine/RingBuffer.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Push a whole file through the ring the old way (decode into a scratch chunk, memcpy into the
+// ring, memcpy out) and the zero-copy way (decode straight into an acquired region, one copy out),
+// and report how many bytes our code copies per second of audio and how long each pass takes.
+// The decoder's own output write is not counted: both paths do it exactly once.
+
+namespace {
+  constexpr ma_uint32 Channels = 2;
+  constexpr ma_uint32 SampleRate = 48000;
+  constexpr ma_uint64 ChunkFrames = SampleRate / 50; // Same 20 ms chunk as the filler
+  constexpr ma_uint64 PeriodFrames = 480;            // A 10 ms device period
+
+  struct Result {
+    ma_uint64 frames = 0;
+    ma_uint64 bytesCopied = 0;
+    double seconds = 0;
+  };
+
+  Result Run(const char* file, bool zeroCopy) {
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, Channels, SampleRate);
+    ma_decoder decoder;
+    if (ma_decoder_init_file(file, &config, &decoder) != MA_SUCCESS) {
+      return {};
+    }
+
+    const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(ma_format_f32, Channels);
+    RingBuffer ring;
+    ring.Allocate(SampleRate, bytesPerFrame);
+    std::vector<ma_uint8> chunk(ChunkFrames * bytesPerFrame);
+    std::vector<ma_uint8> output(PeriodFrames * bytesPerFrame);
+
+    Result result;
+    const auto start = std::chrono::steady_clock::now();
+    bool atEnd = false;
+    while (!atEnd || ring.AvailableRead() > 0) {
+      // Producer: top the ring up
+      while (!atEnd && ring.AvailableWrite() >= ChunkFrames) {
+        ma_uint64 framesRead = 0;
+        if (zeroCopy) {
+          const RingBuffer::WriteRegion region = ring.AcquireWrite(ChunkFrames);
+          ma_decoder_read_pcm_frames(&decoder, region.s_data, region.s_frames, &framesRead);
+          ring.CommitWrite(framesRead);
+        } else {
+          ma_decoder_read_pcm_frames(&decoder, chunk.data(), ChunkFrames, &framesRead);
+          ring.Write(chunk.data(), framesRead);
+          result.bytesCopied += framesRead * bytesPerFrame;
+        }
+        atEnd = framesRead == 0;
+      }
+
+      // Consumer: one period into the device buffer
+      const ma_uint64 read = ring.Read(output.data(), PeriodFrames);
+      result.bytesCopied += read * bytesPerFrame;
+      result.frames += read;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ma_decoder_uninit(&decoder);
+    return result;
+  }
+
+  void Report(const char* name, const Result& result) {
+    const double audioSeconds = static_cast<double>(result.frames) / SampleRate;
+    printf("%-10s %10.0f bytes copied / s of audio   %8.3f ms / s of audio\n", name,
+           result.bytesCopied / audioSeconds, result.seconds * 1000.0 / audioSeconds);
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: ring_copy_bench <file>\n");
+    return -1;
+  }
+
+  const Result before = Run(argv[1], false);
+  const Result after = Run(argv[1], true);
+  if (before.frames == 0 || before.frames != after.frames) {
+    printf("Could not decode file (or the passes disagree): %s\n", argv[1]);
+    return -2;
+  }
+
+  printf("%llu frames (%.1f s of audio)\n", static_cast<unsigned long long>(before.frames),
+         static_cast<double>(before.frames) / SampleRate);
+  Report("chunk", before);
+  Report("zero-copy", after);
+  return 0;
+}
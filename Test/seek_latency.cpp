@@ -0,0 +1,91 @@
+#include "../miniaudio/miniaudio.h"
+
+#include "../Engine/Buffering.hpp"
+#include "../Engine/DataCallback.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Seek benchmark: time from RequestSeek() to the first callback that hands the device
+// frames from the new position, with the callback paced like a real device period.
+// The first frames delivered after each seek are checked against a reference decode.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printf("Usage: seek_latency <file> [seeks] [period_ms]\n");
+    return -1;
+  }
+  const int seeks = argc > 2 ? std::stoi(argv[2]) : 50;
+  const int periodMs = argc > 3 ? std::stoi(argv[3]) : 10;
+
+  // Same output format the engine uses
+  const ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 2, 48000);
+  ma_decoder decoder, reference;
+  if (ma_decoder_init_file(argv[1], &config, &decoder) != MA_SUCCESS ||
+      ma_decoder_init_file(argv[1], &config, &reference) != MA_SUCCESS) {
+    printf("Could not load file: %s\n", argv[1]);
+    return -2;
+  }
+  ma_uint64 length = 0;
+  ma_decoder_get_length_in_pcm_frames(&reference, &length);
+  const ma_uint32 bytesPerFrame = ma_get_bytes_per_frame(config.format, config.channels);
+  const ma_uint32 periodFrames = config.sampleRate * periodMs / 1000;
+  if (length <= config.sampleRate) {
+    printf("File too short\n");
+    return -2;
+  }
+
+  std::vector<double> latencies;
+  int mismatches = 0;
+  {
+    AudioBuffering buffering(&decoder);
+    ma_device device{};
+    device.pUserData = &buffering.GetStreamContext();
+
+    std::vector<ma_uint8> output(periodFrames * bytesPerFrame);
+    std::vector<ma_uint8> expected(periodFrames * bytesPerFrame);
+    std::mt19937_64 rng(1234);
+    std::uniform_int_distribution<ma_uint64> position(0, length - config.sampleRate);
+
+    auto next = std::chrono::steady_clock::now();
+    auto period = [&]() {
+      next += std::chrono::milliseconds(periodMs);
+      std::this_thread::sleep_until(next);
+      data_callback(&device, output.data(), NULL, periodFrames);
+    };
+
+    // Let the ring fill up like it would during normal playback
+    for (int i = 0; i < 100; ++i) period();
+
+    for (int i = 0; i < seeks; ++i) {
+      const ma_uint64 target = position(rng);
+      const ma_uint32 completed = buffering.GetCompletedSeeks();
+      buffering.RequestSeek(target);
+      do { period(); } while (buffering.GetCompletedSeeks() == completed);
+      latencies.push_back(buffering.GetLastSeekLatencyMs());
+
+      // The callback that completed the seek starts with the frame at the target
+      ma_uint64 framesRead = 0;
+      ma_decoder_seek_to_pcm_frame(&reference, target);
+      ma_decoder_read_pcm_frames(&reference, expected.data(), 1, &framesRead);
+      if (memcmp(output.data(), expected.data(), bytesPerFrame) != 0) ++mismatches;
+
+      // Play a little before the next scrub
+      for (int j = 0; j < 20; ++j) period();
+    }
+  }
+  ma_decoder_uninit(&decoder);
+  ma_decoder_uninit(&reference);
+
+  std::sort(latencies.begin(), latencies.end());
+  printf("seeks: %d, period: %d ms, wrong first sample: %d\n", seeks, periodMs, mismatches);
+  printf("seek -> first correct sample (ms): min %.3f, median %.3f, p95 %.3f, max %.3f\n",
+         latencies.front(), latencies[latencies.size() / 2],
+         latencies[latencies.size() * 95 / 100], latencies.back());
+  return mismatches == 0 ? 0 : 1;
+}
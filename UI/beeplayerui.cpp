@@ -23,6 +23,7 @@
 #include <QTimer>
 #include <QtConcurrent/QtConcurrent>
 #include <QFontDatabase>
+#include <QScrollBar>
 
 // we use this to build an ui, and usually explicit passby the root path to provide that PlayerController can be workfine.
 BeeplayerUI::BeeplayerUI(QWidget *parent, std::string RootPath)
@@ -37,15 +38,7 @@ BeeplayerUI::BeeplayerUI(QWidget *parent, std::string RootPath)
         connect(ui->SelectorSubmit, &QPushButton::clicked, this, &BeeplayerUI::onPathSubmitted); // Pass the root Path to PlayerController, or input by your own
         // ui->MainUI->setVisible(false); // Hide the Beeplayer Main Windows
     } else{
-        if(this->controller->Initialize(RootPath)) {// If init is ok
-            this->RenderSongList(); // render the Player List for Beeplayer Main Windows
-            Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_PATH, "Set Path by -root:", RootPath);
-            ui->HeaderPanel->setVisible(false);
-            this->isSetPath = true;
-            this->SetSongName();
-            this->UpdateAlbumArt();
-            progressTimer->start(); // 启动进度更新定时器
-        }
+        this->StartInitialize(RootPath, "by -root");
     }
 
     // 歌曲切换回调
@@ -55,6 +48,14 @@ BeeplayerUI::BeeplayerUI(QWidget *parent, std::string RootPath)
         }, Qt::QueuedConnection);
     });
 
+    // Files added, removed or renamed in the library folder: the list changes, the playing track does not
+    this->controller->SetLibraryChangeCallback([this]() {
+        QMetaObject::invokeMethod(this, [this]() {
+            this->RenderSongList();
+            this->SetSongName();
+        }, Qt::QueuedConnection);
+    });
+
     // List Switch Song
     connect(ui->SongList, &QListView::doubleClicked,
             this, &BeeplayerUI::on_SongList_doubleClicked);
@@ -128,29 +129,112 @@ void BeeplayerUI::BasicInit() {
 
 BeeplayerUI::~BeeplayerUI()
 {
+    if (initThread) {
+        initThread->wait(); // The controller is in use until Initialize() returns
+        delete initThread;
+    }
+    delete songModel; // Waits for its tag lookups, they go through the controller
+    songModel = nullptr;
     delete ui;
     delete controller;
 }
 
+// Initialize() scans the library, which freezes the window for a long time on a big one. It runs on a
+// worker thread instead, and the list shows the files in batches as the scanner finds them.
+void BeeplayerUI::StartInitialize(const std::string& RootPath, const std::string& Source) {
+    if (initThread) {
+        Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_QT, "Still scanning, ignored: ", RootPath);
+        return;
+    }
+
+    if (songModel) {
+        songModel->Clear(); // The controller is re-initialised, no lookups into the old library
+    }
+    // Nothing to play or switch to until FinishInitialize(), the list only shows what the scan found so far
+    this->SetPlaybackControlsEnabled(false);
+    scanModel = new QStringListModel(this);
+    ui->SongList->setModel(scanModel);
+    QStringListModel *model = scanModel;
+    this->controller->SetScanBatchCallback([this, model](const std::vector<std::string>& batch) {
+        QStringList names;
+        names.reserve(static_cast<int>(batch.size()));
+        for (const auto& song : batch) {
+            names.append(QString::fromStdString(song));
+        }
+        QMetaObject::invokeMethod(this, [model, names]() {
+            const int row = model->rowCount();
+            model->insertRows(row, names.size());
+            for (int i = 0; i < names.size(); ++i) {
+                model->setData(model->index(row + i), names[i]);
+            }
+        }, Qt::QueuedConnection);
+    });
+
+    initThread = QThread::create([this, RootPath, Source]() {
+        const bool succeeded = this->controller->Initialize(RootPath);
+        // Queued behind every batch the scan posted
+        QMetaObject::invokeMethod(this, [this, succeeded, RootPath, Source]() {
+            this->FinishInitialize(succeeded, RootPath, Source);
+        }, Qt::QueuedConnection);
+    });
+    initThread->start();
+}
+
+void BeeplayerUI::FinishInitialize(bool Succeeded, const std::string& RootPath, const std::string& Source) {
+    initThread->wait();
+    delete initThread;
+    initThread = nullptr;
+    scanModel->deleteLater(); // Replaced by RenderSongList() below, or nothing to show
+    scanModel = nullptr;
+    this->SetPlaybackControlsEnabled(true);
+
+    if (!Succeeded) {
+        Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_QT, "Error to set Path ", Source, ": ", RootPath);
+        return;
+    }
+    this->isSetPath = true;
+    ui->HeaderPanel->setVisible(false);
+    this->RenderSongList(); // render the Player List for Beeplayer Main Windows, sorted now
+    Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_QT, "Set Path ", Source, ": ", RootPath);
+    this->SetSongName();
+    this->UpdateAlbumArt();
+    progressTimer->start(); // 启动进度更新定时器
+}
+
 // Custom Fucntions
-// We use std::vector (our Path Lib's API Type) trans to QString(QtLib's API Type) then render to QListView entity
-void BeeplayerUI::RenderSongList() {
-    // Get data via PathLib's API
-    std::vector<std::string> SongList = this->controller->GetTracks();
+// The buttons, the volume and the seek bar talk to the controller, they are off while it is being initialised
+void BeeplayerUI::SetPlaybackControlsEnabled(bool enabled) {
+    ui->PlayControlBtn->setEnabled(enabled);
+    ui->PlayPrevBtn->setEnabled(enabled);
+    ui->PlayNextBtn->setEnabled(enabled);
+    ui->PlayStopBtn->setEnabled(enabled);
+    volumeSlider->setEnabled(enabled);
+    progressWidget->setEnabled(enabled);
+}
 
+// The list view reads the engine's track list through SongListModel, rows are only built for what is on screen
+void BeeplayerUI::RenderSongList() {
     QListView *ListView = ui->SongList;
 
-    // 将 std::string 转换为 QString
-    QStringList stringList;
-    for (const auto& song : SongList) {
-        stringList.append(QString::fromStdString(song));
+    if (!songModel) {
+        songModel = new SongListModel(controller, this);
+    }
+    songModel->SetTracks(this->controller->GetTracks());
+    if (ListView->model() != songModel) {
+        ListView->setModel(songModel);
+        ListView->setUniformItemSizes(true); // Row heights are not measured one by one
+    } else {
+        // The library watcher calls this again with the changed list: same model, keep the scroll position
+        const int scrolled = ListView->verticalScrollBar()->value();
+        QTimer::singleShot(0, ListView, [ListView, scrolled]() {
+            ListView->verticalScrollBar()->setValue(scrolled); // Once the reset rows are laid out
+        });
     }
 
-    // 创建字符串列表模型并设置数据
-    QStringListModel *model = new QStringListModel(stringList, this);
-
-    // 将模型设置给 ListView
-    ListView->setModel(model);
+    const QModelIndex current = songModel->IndexOfTrack(controller->GetCurrentTrackIndex());
+    if (current.isValid()) {
+        ListView->setCurrentIndex(current);
+    }
     ui->SongList->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff); // hidden the slider
 }
 
@@ -255,8 +339,8 @@ void BeeplayerUI::UpdateTrackInfo(size_t trackIndex)
     this->m_albumArt->resumeRotation();
 
     // 更新列表选中项
-    if (ui->SongList->model()) {
-        QModelIndex modelIndex = ui->SongList->model()->index(static_cast<int>(trackIndex), 0);
+    if (songModel) {
+        QModelIndex modelIndex = songModel->IndexOfTrack(trackIndex); // May not be fetched yet
         ui->SongList->setCurrentIndex(modelIndex);
         ui->SongList->scrollTo(modelIndex);
     }
@@ -286,20 +370,23 @@ QPixmap BeeplayerUI::RoundedPixmap(const QPixmap& source, int size)
 }
 
 void BeeplayerUI::UpdatePlaybackProgress() {
-    if (!controller || !controller->IsInitialized() ||
-        !controller->IsPlaying() || isSeeking) {
+    if (!controller || !controller->IsInitialized() || isSeeking) {
         return;
     }
 
-    // 获取当前进度和时间
-    float currentTime = controller->GetCurrentTime();
-    float totalTime = controller->GetTotalTime();
-    float progress = controller->GetCurrentProgress();
+    // 获取当前进度和时间: one snapshot, so time, length and progress belong to the same frame and track
+    const PlaybackSnapshot snapshot = controller->GetPlaybackSnapshot();
+    if (snapshot.s_state != PlaybackState::Playing || snapshot.s_sampleRate == 0) {
+        return;
+    }
+    const double currentTime = controller->GetHeardFrame(snapshot) / snapshot.s_sampleRate;
+    const double totalTime = static_cast<double>(snapshot.s_totalFrames) / snapshot.s_sampleRate;
+    const double progress = snapshot.s_totalFrames > 0 ? currentTime / totalTime : 0.0;
 
     // 更新进度控件显示
-    progressWidget->setCurrentTime(currentTime);
-    progressWidget->setTotalTime(totalTime);
-    progressWidget->setProgress(progress);
+    progressWidget->setCurrentTime(static_cast<float>(currentTime));
+    progressWidget->setTotalTime(static_cast<float>(totalTime));
+    progressWidget->setProgress(static_cast<float>(progress));
 }
 
 void BeeplayerUI::OnSeekRequested(float progress) {
@@ -310,8 +397,8 @@ void BeeplayerUI::OnSeekRequested(float progress) {
     Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_QT, "Seek requested to:" , progress * 100 , "%");
 
     // 更新预览显示
-    float totalTime = controller->GetTotalTime();
-    progressWidget->setCurrentTime(progress * totalTime);
+    const double totalTime = controller->GetTotalTime();
+    progressWidget->setCurrentTime(static_cast<float>(progress * totalTime));
 
     // 暂停自动进度更新
     progressTimer->stop();
@@ -371,19 +458,7 @@ void BeeplayerUI::onPathSubmitted() {
             return;
         }
 
-        if (this->controller->Initialize(currentSongPath)) {
-            // ui->MainUI->setVisible(true);
-            // ui->HeaderPanel->setVisible(false);
-            this->isSetPath = true;
-            ui->HeaderPanel->setVisible(false);
-            this->RenderSongList();
-            Log::LogOut(LogLevel::BP_INFO, LogChannel::CH_QT, "Set Path with QtUI:", currentSongPath);
-            this->SetSongName();
-            this->UpdateAlbumArt();
-            progressTimer->start(); // 启动进度更新定时器
-        } else {
-            Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_QT, "Error to set Path with QtUI:", currentSongPath);
-        }
+        this->StartInitialize(currentSongPath, "with QtUI");
     } else {
         Log::LogOut(LogLevel::BP_WARNING, LogChannel::CH_QT, "Empty Path");
     }
@@ -473,6 +548,11 @@ void BeeplayerUI::on_PlayStopBtn_clicked()
 
 void BeeplayerUI::on_SongList_doubleClicked(const QModelIndex &index)
 {
+    // The rows of the scan in progress are not tracks of the controller yet
+    if (initThread || !controller->IsInitialized() || index.model() != songModel) {
+        return;
+    }
+
     if(this->controller->IsPlaying() == true) {
         controller->Stop();
     }
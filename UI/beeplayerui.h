@@ -10,10 +10,13 @@
 #define BEEPLAYERUI_H
 
 #include <QMainWindow>
+#include <QStringListModel>
+#include <QThread>
 #include "../Engine/Controller.hpp"
 #include "Animations/rotatingalbumart.h"
 #include "volumeslider.h"
 #include "progresswidget.h"
+#include "songlistmodel.h"
 
 namespace Ui {
 class BeeplayerUI;
@@ -29,6 +32,9 @@ public:
     void BasicInit();
     void LoadStyleSheet(const QString &path);
     void RenderSongList();
+    void StartInitialize(const std::string& RootPath, const std::string& Source);
+    void FinishInitialize(bool Succeeded, const std::string& RootPath, const std::string& Source);
+    void SetPlaybackControlsEnabled(bool enabled);
     void RenderVolumeSlider();
     void SetSongName();
     void SetupScrollLabels();
@@ -70,6 +76,9 @@ private:
     PlayerController *controller = nullptr;
     std::string currentSongPath;
     bool isSetPath = false;
+    QThread *initThread = nullptr;         // Runs controller->Initialize(), the scan can take a while
+    QStringListModel *scanModel = nullptr; // What the scanner found so far, until the final list replaces it
+    SongListModel *songModel = nullptr;    // The library, read from the controller's track list as the view scrolls
 
     // Volume
     VolumeSlider *volumeSlider;
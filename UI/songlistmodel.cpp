@@ -0,0 +1,216 @@
+#include "songlistmodel.h"
+
+#include <algorithm>
+#include <climits>
+
+SongListModel::SongListModel(PlayerController *controller, QObject *parent)
+    : QAbstractListModel(parent), controller(controller), tracks(std::make_shared<const TrackStore>()) {
+    pool.setMaxThreadCount(1); // One reader, the newest request first
+}
+
+SongListModel::~SongListModel() {
+    CancelLookups(); // The worker uses the controller and this
+}
+
+void SongListModel::SetTracks(PlayerController::TrackList list) {
+    if (!list) {
+        list = std::make_shared<const TrackStore>();
+    }
+    const int size = static_cast<int>(std::min<size_t>(list->Size(), INT_MAX));
+
+    beginResetModel();
+    tracks = std::move(list);
+    loaded = std::min(size, std::max(loaded, FetchChunk));
+    // A changed file keeps its id, its tags are read again (from the index, that is cheap)
+    ++generation;
+    cache.clear();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.clear();
+    }
+    requested.clear();
+    endResetModel();
+}
+
+void SongListModel::Clear() {
+    beginResetModel();
+    CancelLookups();
+    tracks = std::make_shared<const TrackStore>();
+    loaded = 0;
+    ++generation;
+    cache.clear();
+    endResetModel();
+}
+
+QModelIndex SongListModel::IndexOfTrack(size_t track) {
+    if (track >= tracks->Size() || track >= static_cast<size_t>(INT_MAX)) {
+        return QModelIndex();
+    }
+    const int row = static_cast<int>(track);
+    if (row >= loaded) {
+        // Up to the end of the chunk holding it, so the rows around it are there when it is scrolled to
+        const int size = static_cast<int>(std::min<size_t>(tracks->Size(), INT_MAX));
+        const int last = std::min(size, (row / FetchChunk + 1) * FetchChunk);
+        beginInsertRows(QModelIndex(), loaded, last - 1);
+        loaded = last;
+        endInsertRows();
+    }
+    return index(row, 0);
+}
+
+int SongListModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : loaded;
+}
+
+bool SongListModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && static_cast<size_t>(loaded) < tracks->Size() && loaded < INT_MAX;
+}
+
+void SongListModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    const int size = static_cast<int>(std::min<size_t>(tracks->Size(), INT_MAX));
+    const int last = std::min(size, loaded + FetchChunk);
+    beginInsertRows(QModelIndex(), loaded, last - 1);
+    loaded = last;
+    endInsertRows();
+}
+
+QVariant SongListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= loaded) {
+        return QVariant();
+    }
+    const size_t row = static_cast<size_t>(index.row());
+
+    switch (role) {
+    case PathRole:
+    case Qt::ToolTipRole: {
+        std::string path;
+        tracks->AppendPath(row, path);
+        return QString::fromStdString(path);
+    }
+    case TrackIdRole:
+        return QVariant::fromValue<quint32>(tracks->Id(row));
+    case Qt::DisplayRole:
+    case TitleRole:
+    case ArtistRole:
+    case DurationRole:
+        break;
+    default:
+        return QVariant();
+    }
+
+    const auto found = cache.constFind(tracks->Id(row));
+    if (found == cache.constEnd()) {
+        RequestTags(row);
+        if (role != Qt::DisplayRole) {
+            return QVariant();
+        }
+        // Until the tags are in
+        std::string path;
+        tracks->AppendPath(row, path);
+        return QString::fromStdString(path);
+    }
+
+    const Tags &tags = found.value();
+    switch (role) {
+    case TitleRole:
+        return tags.title;
+    case ArtistRole:
+        return tags.artist;
+    case DurationRole:
+        return tags.durationMs;
+    default:
+        break;
+    }
+    // 有标题就显示 "标题 - 艺术家", 否则还是文件路径
+    if (tags.title.isEmpty()) {
+        std::string path;
+        tracks->AppendPath(row, path);
+        return QString::fromStdString(path);
+    }
+    return tags.artist.isEmpty() ? tags.title : tags.title + QStringLiteral(" - ") + tags.artist;
+}
+
+void SongListModel::RequestTags(size_t row) const {
+    const TrackId id = tracks->Id(row);
+    if (requested.contains(id)) {
+        return;
+    }
+    requested.insert(id);
+
+    bool start = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back({id, tracks->Path(row), generation});
+        if (queue.size() > static_cast<size_t>(MaxQueued)) {
+            // Scrolled past, asked again if it comes back into view
+            requested.remove(queue.front().id);
+            queue.erase(queue.begin());
+        }
+        if (!workerRunning) {
+            workerRunning = true;
+            start = true;
+        }
+    }
+    if (start) {
+        SongListModel *self = const_cast<SongListModel *>(this);
+        pool.start([self]() { self->RunLookups(); });
+    }
+}
+
+void SongListModel::RunLookups() {
+    for (;;) {
+        Lookup next;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (queue.empty()) {
+                workerRunning = false;
+                return;
+            }
+            next = std::move(queue.back());
+            queue.pop_back();
+        }
+
+        TrackInfo info;
+        const bool found = controller->GetTrackInfo(next.path, info);
+        QMetaObject::invokeMethod(this, [this, id = next.id, fromGeneration = next.generation, found, info]() {
+            this->OnTags(id, fromGeneration, found, info);
+        }, Qt::QueuedConnection);
+    }
+}
+
+void SongListModel::OnTags(TrackId id, quint64 fromGeneration, bool found, const TrackInfo &info) {
+    if (fromGeneration != generation) {
+        return; // For a list that is gone
+    }
+    requested.remove(id);
+
+    if (cache.size() >= MaxCached) {
+        cache.clear(); // Whatever is still on screen asks again
+    }
+    Tags &tags = cache[id]; // Unreadable files too, so they are not asked for again and again
+    if (found && info.s_hasTags) {
+        tags.title = QString::fromStdString(info.s_title);
+        tags.artist = QString::fromStdString(info.s_artist);
+    }
+    if (found) {
+        tags.durationMs = info.s_durationMs;
+    }
+
+    const size_t row = tracks->IndexOf(id);
+    if (row < static_cast<size_t>(loaded)) {
+        const QModelIndex changed = index(static_cast<int>(row), 0);
+        emit dataChanged(changed, changed, {Qt::DisplayRole, TitleRole, ArtistRole, DurationRole});
+    }
+}
+
+void SongListModel::CancelLookups() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.clear();
+    }
+    requested.clear();
+    pool.waitForDone(); // At most the one lookup being read
+}
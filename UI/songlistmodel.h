@@ -0,0 +1,85 @@
+#ifndef SONGLISTMODEL_H
+#define SONGLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QSet>
+#include <QThreadPool>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Engine/Controller.hpp"
+
+// The song list, read straight from the controller's TrackStore: no copy of the library is made.
+// Rows are handed to the view a chunk at a time (canFetchMore / fetchMore) and their text is built
+// when the view asks for it, so only what is on screen costs anything. Tags are looked up in the
+// library index on a worker thread, the row shows the file path until they arrive.
+class SongListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        PathRole = Qt::UserRole + 1, // Relative path, what the list showed before tags were known
+        TitleRole,
+        ArtistRole,
+        DurationRole,                // Milliseconds
+        TrackIdRole
+    };
+
+    static constexpr int FetchChunk = 512;   // Rows added per fetchMore()
+    static constexpr int MaxCached = 4096;   // Tags kept, about a few screens worth
+    static constexpr int MaxQueued = 256;    // Lookups waiting, the oldest (scrolled past) are dropped
+
+    explicit SongListModel(PlayerController *controller, QObject *parent = nullptr);
+    ~SongListModel() override;
+
+    // A new list (library loaded or changed), the rows fetched so far stay fetched
+    void SetTracks(PlayerController::TrackList tracks);
+    // Forget the list and wait for the lookups in flight, before the controller is re-initialised
+    void Clear();
+
+    // Index of a track, fetching the rows up to it first. Invalid when there is no such track.
+    QModelIndex IndexOfTrack(size_t track);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    struct Tags {
+        QString title;
+        QString artist;
+        quint32 durationMs = 0;
+    };
+
+    struct Lookup {
+        TrackId id;
+        std::string path;
+        quint64 generation;
+    };
+
+    PlayerController *controller;
+    PlayerController::TrackList tracks;
+    int loaded = 0;          // Rows the view has
+    quint64 generation = 0;  // Bumped with every list, late results of an older one are dropped
+
+    // UI thread only
+    mutable QHash<TrackId, Tags> cache;
+    mutable QSet<TrackId> requested; // Queued or being read
+
+    // Shared with the worker
+    mutable std::mutex queueMutex;
+    mutable std::vector<Lookup> queue; // Newest last, served first: what is on screen now
+    mutable bool workerRunning = false;
+    mutable QThreadPool pool;
+
+    void RequestTags(size_t row) const;
+    void RunLookups();
+    void OnTags(TrackId id, quint64 fromGeneration, bool found, const TrackInfo &info);
+    void CancelLookups();
+};
+
+#endif // SONGLISTMODEL_H
@@ -0,0 +1,423 @@
+/*
+ *  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *
+ *  Beeplayer - bench
+ *  Engine benchmarks: decode throughput, switch / seek latency, callback time, library scan and metadata.
+ *  Runs on the null output sink, no sound card needed. Results are written as JSON (beeplayer_bench.json by default).
+ *
+ *  Thanks to David Reid provided us a such powerful and useful lib "miniaudio"
+ *
+ *  Thanks to music make the world so beautiful. :)
+ */
+
+// Standard Lib
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Basic Lib
+#include "Engine/Buffering.hpp"
+#include "Engine/DataCallback.hpp"
+#include "Engine/Decoder.hpp"
+#include "Engine/Device.hpp"
+#include "Engine/OfflineSink.hpp"
+#include "Engine/Player.hpp"
+#include "Engine/Status.hpp"
+#include "FileSystem/Metadata.hpp"
+#include "FileSystem/Path.hpp"
+#include "Log/LogSystem.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+	using Fields = std::vector<std::pair<std::string, double>>;
+
+	double Milliseconds(Clock::duration Duration) {
+		return std::chrono::duration<double, std::milli>(Duration).count();
+	}
+
+	struct Options {
+		std::string s_media;          // Folder with real files, a synthetic WAV is used without one
+		std::string s_json = "beeplayer_bench.json"; // Not stdout, the log writes there
+		size_t s_scanFiles = 100000;  // Files in the synthetic library tree
+		size_t s_iterations = 50;     // Switches and seeks
+		size_t s_callbacks = 20000;   // data_callback calls timed
+		ma_uint32 s_periodFrames = OfflineSink::DefaultPeriodFrames;
+	};
+
+	// One flat object per benchmark: {"name": ..., "<field>": <number>, ...}
+	class JsonReport {
+		public:
+			void Add(const std::string& Name, const Fields& Values) {
+				p_entries.emplace_back(Name, Values);
+				fprintf(stderr, "%-24s", Name.c_str());
+				for (const auto& [key, value] : Values) {
+					fprintf(stderr, " %s=%.4g", key.c_str(), value);
+				}
+				fprintf(stderr, "\n");
+			}
+
+			void Write(FILE* Out, const Options& Settings) const {
+				char date[32] = {};
+				const std::time_t now = std::time(nullptr);
+				std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+				fprintf(Out, "{\n  \"context\": {\"date\": \"%s\", \"output_rate\": %u, \"period_frames\": %u, \"media\": \"%s\"},\n",
+						date, AudioDevice::OutputSampleRate, Settings.s_periodFrames, Escape(Settings.s_media).c_str());
+				fprintf(Out, "  \"benchmarks\": [\n");
+				for (size_t i = 0; i < p_entries.size(); ++i) {
+					fprintf(Out, "    {\"name\": \"%s\"", Escape(p_entries[i].first).c_str());
+					for (const auto& [key, value] : p_entries[i].second) {
+						fprintf(Out, ", \"%s\": %s", key.c_str(), Number(value).c_str());
+					}
+					fprintf(Out, "}%s\n", i + 1 < p_entries.size() ? "," : "");
+				}
+				fprintf(Out, "  ]\n}\n");
+			}
+
+		private:
+			std::vector<std::pair<std::string, Fields>> p_entries;
+
+			static std::string Escape(const std::string& Text) {
+				std::string out;
+				for (const char c : Text) {
+					if (c == '"' || c == '\\') {
+						out += '\\';
+						out += c;
+					} else if (static_cast<unsigned char>(c) < 0x20) {
+						char code[8];
+						snprintf(code, sizeof(code), "\\u%04x", c);
+						out += code;
+					} else {
+						out += c;
+					}
+				}
+				return out;
+			}
+
+			static std::string Number(double Value) {
+				if (!std::isfinite(Value)) {
+					return "null";
+				}
+				char text[32];
+				snprintf(text, sizeof(text), "%.6g", Value);
+				return text;
+			}
+	};
+
+	// Distribution of a sample set, in the unit of the samples
+	Fields Distribution(std::vector<double> Samples) {
+		if (Samples.empty()) {
+			return {{"samples", 0}};
+		}
+		std::sort(Samples.begin(), Samples.end());
+		const auto at = [&Samples](double Quantile) {
+			return Samples[std::min(Samples.size() - 1, static_cast<size_t>(Quantile * Samples.size()))];
+		};
+		double sum = 0;
+		for (const double sample : Samples) sum += sample;
+		return {{"samples", static_cast<double>(Samples.size())}, {"mean", sum / Samples.size()}, {"p50", at(0.5)},
+				{"p90", at(0.9)}, {"p99", at(0.99)}, {"p999", at(0.999)}, {"max", Samples.back()}};
+	}
+
+	// 30 s of a 16 bit 44.1 kHz sweep, so the decoders also have to resample to the output rate
+	bool WriteSyntheticWav(const fs::path& File) {
+		constexpr ma_uint32 rate = 44100;
+		const ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_s16, 2, rate);
+		ma_encoder encoder;
+		if (ma_encoder_init_file(File.string().c_str(), &config, &encoder) != MA_SUCCESS) {
+			return false;
+		}
+		std::vector<ma_int16> block(2 * 4096);
+		double phase = 0;
+		for (ma_uint32 frame = 0; frame < rate * 30;) {
+			const ma_uint32 frames = std::min<ma_uint32>(4096, rate * 30 - frame);
+			for (ma_uint32 i = 0; i < frames; ++i, ++frame) {
+				phase += 2.0 * 3.14159265358979 * (220.0 + frame / 100.0) / rate;
+				const auto sample = static_cast<ma_int16>(std::sin(phase) * 16000.0);
+				block[2 * i] = sample;
+				block[2 * i + 1] = sample;
+			}
+			ma_encoder_write_pcm_frames(&encoder, block.data(), frames, nullptr);
+		}
+		ma_encoder_uninit(&encoder);
+		return true;
+	}
+
+	// A generated library and what a Path left for it in the cache. Call it once no Path on Root is alive,
+	// ~Path() writes the index.
+	void RemoveLibrary(const fs::path& Root) {
+		std::error_code error;
+		fs::remove_all(Root, error);
+		fs::remove(Path::LibraryCacheFile(Root, "bls"), error);
+		fs::remove(Path::LibraryCacheFile(Root, "bli"), error);
+	}
+
+	std::string Extension(const std::string& File) {
+		std::string extension = fs::path(File).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+		return extension.empty() ? "none" : extension.substr(1);
+	}
+
+	// Whole files through miniaudio at the output format, per container
+	void BenchDecode(const Path& Library, JsonReport& Report) {
+		struct Total { size_t s_files = 0; ma_uint64 s_frames = 0; double s_ms = 0; };
+		std::map<std::string, Total> totals;
+		std::vector<float> block(4096 * AudioDevice::OutputChannels);
+
+		const ma_decoder_config config = AudioDevice::DecoderConfig();
+		for (size_t i = 0; i < Library.TotalSong(); ++i) {
+			const std::string file = Library.FilePath(i);
+			const auto start = Clock::now();
+			ma_decoder decoder;
+			if (ma_decoder_init_file(file.c_str(), &config, &decoder) != MA_SUCCESS) {
+				continue;
+			}
+			ma_uint64 frames = 0, read = 0;
+			while (ma_decoder_read_pcm_frames(&decoder, block.data(), 4096, &read) == MA_SUCCESS && read > 0) {
+				frames += read;
+			}
+			ma_decoder_uninit(&decoder);
+
+			Total& total = totals[Extension(file)];
+			total.s_files++;
+			total.s_frames += frames;
+			total.s_ms += Milliseconds(Clock::now() - start);
+		}
+
+		for (const auto& [format, total] : totals) {
+			const double audioSeconds = static_cast<double>(total.s_frames) / AudioDevice::OutputSampleRate;
+			Report.Add("decode/" + format, {{"files", static_cast<double>(total.s_files)}, {"audio_seconds", audioSeconds},
+											{"ms", total.s_ms}, {"x_realtime", audioSeconds * 1000.0 / total.s_ms}});
+		}
+	}
+
+	// Both run on a paced null sink with the balanced profile, like a real device would pull
+	void BenchSwitchAndSeek(const std::string& Root, const Options& Settings, JsonReport& Report) {
+		Path pather(Root);
+		AudioDecoder decoder;
+		AudioPlayer player;
+		player.InitDecoder(pather, decoder);
+		Status timer(decoder);
+
+		const LatencyProfile& profile = GetLatencyProfile(LatencyMode::Balanced);
+		AudioBuffering buffer;
+		buffer.ApplyLatencyProfile(profile);
+		buffer.SetGapless(false); // Keep the stream to ourselves, no prepared next track
+		buffer.StartFiller(&decoder.GetDecoder(), decoder.GetSeekIndex(), decoder.GetLengthInFrames());
+		NullSink sink(Settings.s_periodFrames, true);
+		player.InitDevice(sink, data_callback, buffer, profile);
+		player.Play(sink, buffer);
+
+		std::vector<double> switches;
+		for (size_t i = 0; i < Settings.s_iterations; ++i) {
+			const auto start = Clock::now();
+			player.Switch(pather, decoder, sink, timer, buffer, SwitchAction::NEXT);
+			switches.push_back(Milliseconds(Clock::now() - start));
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+		Report.Add("switch_ms", Distribution(switches));
+
+		// From the request until the first frame after the seek is handed to the sink
+		std::vector<double> seeks;
+		ma_uint32 random = 12345;
+		const ma_uint64 length = decoder.GetLengthInFrames();
+		for (size_t i = 0; length > 0 && i < Settings.s_iterations; ++i) {
+			random = random * 1664525u + 1013904223u;
+			const ma_uint64 target = static_cast<ma_uint64>(random % 1000) * (length * 9 / 10) / 1000;
+			EngineEvent event;
+			while (buffer.GetEvents().Pop(event)) {}
+
+			const auto start = Clock::now();
+			player.Seek(buffer, target);
+			bool completed = false;
+			while (!completed && Clock::now() - start < std::chrono::seconds(2)) {
+				const ma_uint32 seen = buffer.GetEvents().GetSignal();
+				while (buffer.GetEvents().Pop(event)) {
+					completed |= event.s_type == EngineEventType::SeekCompleted;
+				}
+				if (!completed) buffer.GetEvents().Wait(seen);
+			}
+			if (completed) seeks.push_back(Milliseconds(Clock::now() - start));
+		}
+		Report.Add("seek_ms", Distribution(seeks));
+
+		player.Clean(buffer, timer, decoder, sink);
+		sink.Close();
+	}
+
+	// data_callback alone, fed from a full ring (no underruns), with the gain stage running
+	void BenchCallback(const std::string& File, const Options& Settings, JsonReport& Report) {
+		AudioDecoder decoder;
+		const ma_decoder_config config = AudioDevice::DecoderConfig();
+		if (!decoder.InitDecoder(File, &config)) {
+			return;
+		}
+		std::vector<double> times;
+		{
+			AudioBuffering buffer;
+			buffer.SetGapless(false);
+			buffer.StartFiller(&decoder.GetDecoder(), decoder.GetSeekIndex(), decoder.GetLengthInFrames());
+			buffer.SetGain(0.8f);
+			buffer.SetPaused(false);
+
+			ma_device device{};
+			device.pUserData = &buffer.GetStreamContext();
+			std::vector<float> output(static_cast<size_t>(Settings.s_periodFrames) * AudioDevice::OutputChannels);
+			times.reserve(Settings.s_callbacks);
+			bool ended = false;
+			EngineEvent event;
+			while (times.size() < Settings.s_callbacks) {
+				while (buffer.GetEvents().Pop(event)) {
+					ended |= event.s_type == EngineEventType::TrackEnded;
+				}
+				if (buffer.GetRing().AvailableRead() < Settings.s_periodFrames) {
+					// Loop the track: the tail is shorter than a period, or the last period ended right on it
+					if (ended || buffer.IsEndDecoded()) {
+						buffer.RequestSeek(0);
+						ended = false;
+					}
+					buffer.RequestRefill();
+					std::this_thread::yield();
+					continue;
+				}
+				const auto start = Clock::now();
+				data_callback(&device, output.data(), nullptr, Settings.s_periodFrames);
+				times.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+			}
+		}
+		ma_decoder_uninit(&decoder.GetDecoder());
+		Fields fields = Distribution(times);
+		fields.emplace_back("period_frames", Settings.s_periodFrames);
+		Report.Add("callback_us", fields);
+	}
+
+	// Files spread over folders of 100, one in ten is not media. Only the scan is timed.
+	void BenchScan(size_t Files, JsonReport& Report) {
+		const fs::path root = fs::temp_directory_path() /
+							  ("beeplayer-bench-" + std::to_string(Clock::now().time_since_epoch().count()));
+		std::error_code error;
+		for (size_t i = 0; i < Files; ++i) {
+			const fs::path folder = root / ("artist" + std::to_string(i / 1000)) / ("album" + std::to_string(i / 100));
+			if (i % 100 == 0) fs::create_directories(folder, error);
+			const char* extension = i % 10 == 9 ? ".txt" : i % 2 ? ".mp3" : ".wav";
+			std::ofstream(folder / ("track" + std::to_string(i) + extension));
+		}
+
+		{
+			auto start = Clock::now();
+			Path library(root.string());
+			const double cold = Milliseconds(Clock::now() - start);
+			start = Clock::now();
+			library.Rescan();
+			const double warm = Milliseconds(Clock::now() - start);
+			// The next launch: the list comes from the library index
+			start = Clock::now();
+			const Path indexed(root.string());
+			const double fromIndex = Milliseconds(Clock::now() - start);
+			const double bytesPerTrack = library.TotalSong() ? static_cast<double>(library.GetTracks()->MemoryBytes()) / library.TotalSong() : 0.0;
+
+			Report.Add("scan", {{"files", static_cast<double>(Files)}, {"found", static_cast<double>(library.TotalSong())},
+								{"first_ms", cold}, {"rescan_ms", warm}, {"indexed_start_ms", fromIndex},
+								{"files_per_second", Files * 1000.0 / cold}, {"rescan_files_per_second", Files * 1000.0 / warm},
+								{"bytes_per_track", bytesPerTrack}});
+		}
+		RemoveLibrary(root);
+	}
+
+	void BenchMetadata(const Path& Library, JsonReport& Report) {
+		AudioMetadataReader& reader = AudioMetadataReader::getInstance();
+		size_t read = 0;
+		const auto start = Clock::now();
+		for (size_t i = 0; i < Library.TotalSong(); ++i) {
+			const std::string file = Library.FilePath(i);
+			read += !reader.getSongTitle(file).empty() || !reader.getSongProducer(file).empty();
+		}
+		const double ms = Milliseconds(Clock::now() - start);
+		Report.Add("metadata", {{"files", static_cast<double>(Library.TotalSong())}, {"with_tags", static_cast<double>(read)},
+								{"ms", ms}, {"files_per_second", Library.TotalSong() * 1000.0 / ms}});
+	}
+
+	void PrintUsage() {
+		printf("Usage: beeplayer_bench [-media <music folder>] [-json <file>] [-files <scan tree size>]\n"
+			   "                       [-iterations <switches and seeks>] [-callbacks <count>] [-period <frames>]\n");
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Log::SetViewLogLevel(LogLevel::BP_ERROR); // Only errors between the results on the terminal
+
+	Options settings;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const std::string option = argv[i];
+		const std::string value = argv[i + 1];
+		if (option == "-media") settings.s_media = value;
+		else if (option == "-json") settings.s_json = value;
+		else if (option == "-files") settings.s_scanFiles = std::strtoull(value.c_str(), nullptr, 10);
+		else if (option == "-iterations") settings.s_iterations = std::strtoull(value.c_str(), nullptr, 10);
+		else if (option == "-callbacks") settings.s_callbacks = std::strtoull(value.c_str(), nullptr, 10);
+		else if (option == "-period") settings.s_periodFrames = static_cast<ma_uint32>(std::strtoul(value.c_str(), nullptr, 10));
+		else {
+			PrintUsage();
+			return -1;
+		}
+	}
+	if (argc % 2 == 0 || settings.s_periodFrames == 0) {
+		PrintUsage();
+		return -1;
+	}
+
+	// Without a media folder everything runs on one generated file
+	fs::path synthetic;
+	std::string media = settings.s_media;
+	if (media.empty()) {
+		synthetic = fs::temp_directory_path() / ("beeplayer-bench-media-" + std::to_string(Clock::now().time_since_epoch().count()));
+		std::error_code error;
+		fs::create_directories(synthetic, error);
+		if (!WriteSyntheticWav(synthetic / "sweep.wav")) {
+			fprintf(stderr, "Could not write the synthetic media to %s\n", synthetic.string().c_str());
+			return -2;
+		}
+		media = synthetic.string();
+	}
+	JsonReport report;
+	{
+		// Gone before the synthetic folder is removed, its index would be written back otherwise
+		const Path library(media);
+		if (library.TotalSong() == 0) {
+			fprintf(stderr, "No media files in %s\n", media.c_str());
+			return -2;
+		}
+
+		BenchDecode(library, report);
+		BenchSwitchAndSeek(media, settings, report);
+		BenchCallback(library.FilePath(0), settings, report);
+		BenchScan(settings.s_scanFiles, report);
+		BenchMetadata(library, report);
+	}
+
+	if (!synthetic.empty()) {
+		RemoveLibrary(synthetic);
+	}
+
+	FILE* out = fopen(settings.s_json.c_str(), "w");
+	if (out == nullptr) {
+		fprintf(stderr, "Could not write: %s\n", settings.s_json.c_str());
+		return -3;
+	}
+	report.Write(out, settings);
+	fclose(out);
+	return 0;
+}
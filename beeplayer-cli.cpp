@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2025 Romi Brooks <qq1694821929@gmail.com>
+ *
+ *  Beeplayer - headless
+ *  The Beeplayer engine without any GUI: plays a folder from the terminal, reads commands from stdin.
+ *
+ *  Thanks to David Reid provided us a such powerful and useful lib "miniaudio"
+ *
+ *  Thanks to music make the world so beautiful. :)
+ */
+
+// Standard Lib
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Basic Lib
+#include "Engine/Controller.hpp"
+#include "Engine/OfflineSink.hpp"
+#include "Log/LogSystem.hpp"
+
+namespace {
+	void PrintUsage() {
+		printf("Usage: beeplayer-cli -root <music folder> [-latency low|balanced|power] [-crossfade <seconds>]\n"
+			   "                    [-output device|null|wav:<file>] [-period <frames>]\n");
+	}
+
+	void PrintHelp() {
+		printf("Commands: play, pause, stop, next, prev, switch <index>, seek <0-1>, vol <0-1>,\n"
+			   "          gapless on|off, crossfade <seconds>, status, list, quit\n");
+	}
+
+	// device: the sound card. null / wav render offline as fast as the engine goes, -period sets their callback size.
+	bool MakeSink(const std::string& Name, ma_uint32 PeriodFrames, std::unique_ptr<OutputSink>& Sink) {
+		if (Name == "device") Sink.reset();
+		else if (Name == "null") Sink = std::make_unique<NullSink>(PeriodFrames);
+		else if (Name.rfind("wav:", 0) == 0 && Name.size() > 4) Sink = std::make_unique<WavSink>(Name.substr(4), PeriodFrames);
+		else return false;
+		return true;
+	}
+
+	void PrintStatus(const PlayerController& Controller) {
+		const PlaybackSnapshot snapshot = Controller.GetPlaybackSnapshot();
+		const char* state = snapshot.s_state == PlaybackState::Playing ? "playing"
+						  : snapshot.s_state == PlaybackState::Paused  ? "paused"
+																	   : "stopped";
+		printf("[%s] #%u %s  %.1f / %.1f s  vol %.2f  latency %.1f ms\n", state, snapshot.s_trackId,
+			   Controller.GetCurrentTrackName().c_str(), Controller.GetCurrentTime(), Controller.GetTotalTime(),
+			   Controller.GetVolume(), Controller.GetOutputLatencyMs());
+	}
+
+	bool ParseLatency(const std::string& Name, LatencyMode& Mode) {
+		if (Name == "low") Mode = LatencyMode::LowLatency;
+		else if (Name == "balanced") Mode = LatencyMode::Balanced;
+		else if (Name == "power") Mode = LatencyMode::PowerSave;
+		else return false;
+		return true;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	Log::SetViewLogLevel(LogLevel::BP_WARNING);
+
+	// Win32 Platform Define
+	#ifdef _WIN32
+		SetConsoleOutputCP(CP_UTF8);
+	#endif
+
+	std::string rootPath;
+	LatencyMode latency = LatencyMode::Balanced;
+	float crossfade = 0.0f;
+	std::string output = "device";
+	ma_uint32 periodFrames = OfflineSink::DefaultPeriodFrames;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		const std::string option = argv[i];
+		if (option == "-root") {
+			rootPath = argv[i + 1];
+		} else if (option == "-latency") {
+			if (!ParseLatency(argv[i + 1], latency)) {
+				PrintUsage();
+				return -1;
+			}
+		} else if (option == "-crossfade") {
+			crossfade = static_cast<float>(std::atof(argv[i + 1]));
+		} else if (option == "-output") {
+			output = argv[i + 1];
+		} else if (option == "-period") {
+			periodFrames = static_cast<ma_uint32>(std::strtoul(argv[i + 1], nullptr, 10));
+		} else {
+			PrintUsage();
+			return -1;
+		}
+	}
+	std::unique_ptr<OutputSink> sink;
+	if (rootPath.empty() || !MakeSink(output, periodFrames, sink)) {
+		PrintUsage();
+		return -1;
+	}
+
+	// Settings given before Initialize() are applied while the engine comes up
+	PlayerController controller(sink.get());
+	controller.SetLatencyProfile(latency);
+	controller.SetCrossfade(crossfade);
+	if (!controller.Initialize(rootPath)) {
+		Log::LogOut(LogLevel::BP_ERROR, LogChannel::CH_CONTROLLER, "Could not open: ", rootPath);
+		return -2;
+	}
+	controller.SetTrackChangeCallback([&controller](size_t newIndex) {
+		const PlayerController::TrackList tracks = controller.GetTracks();
+		if (newIndex < tracks->Size()) printf("> %zu: %s\n", newIndex, tracks->Path(newIndex).c_str());
+	});
+	controller.SetLibraryChangeCallback([&controller]() {
+		printf("~ library changed: %zu tracks\n", controller.GetTracks()->Size());
+	});
+
+	PrintHelp();
+	controller.Play();
+
+	std::string line;
+	while (std::getline(std::cin, line)) {
+		std::istringstream input(line);
+		std::string command;
+		input >> command;
+
+		if (command == "play") controller.Play();
+		else if (command == "pause") controller.Pause();
+		else if (command == "stop") controller.Stop();
+		else if (command == "next") controller.Next();
+		else if (command == "prev") controller.Prev();
+		else if (command == "switch") {
+			size_t index = 0;
+			if (input >> index) controller.Switch(index);
+		} else if (command == "seek") {
+			float progress = 0.0f;
+			if (input >> progress) controller.SeekToPosition(progress);
+		} else if (command == "vol") {
+			float volume = 0.0f;
+			if (input >> volume) controller.SetVolume(volume);
+		} else if (command == "gapless") {
+			std::string value;
+			input >> value;
+			controller.SetGapless(value != "off");
+		} else if (command == "crossfade") {
+			float seconds = 0.0f;
+			if (input >> seconds) controller.SetCrossfade(seconds);
+		} else if (command == "status") PrintStatus(controller);
+		else if (command == "list") {
+			const PlayerController::TrackList tracks = controller.GetTracks();
+			for (size_t i = 0; i < tracks->Size(); ++i) {
+				printf("%c %zu: %s\n", i == controller.GetCurrentTrackIndex() ? '*' : ' ', i, tracks->Path(i).c_str());
+			}
+		} else if (command == "quit" || command == "exit") break;
+		else if (!command.empty()) PrintHelp();
+	}
+
+	controller.Cleanup();
+	return 0;
+}
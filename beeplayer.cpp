@@ -21,8 +21,7 @@
 #include <windows.h>
 #endif
 
-// Basic Lib
-#include"miniaudio.c"
+// Basic Lib (miniaudio is compiled into beeplayer_engine)
 #include "UI/beeplayerui.h"
 #include "Log/LogSystem.hpp"
 